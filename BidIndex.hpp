@@ -0,0 +1,1700 @@
+//============================================================================
+// Name        : BidIndex.hpp
+// Author      : Danny Forte
+// Version     : 1.0
+// Copyright   : Copyright  2023 SNHU COCE
+// Description : Bid record, loader and benchmark driver shared by the labs
+//============================================================================
+
+#ifndef BIDINDEX_HPP
+#define BIDINDEX_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <unistd.h> // sysconf
+#endif
+
+using namespace std;
+
+//============================================================================
+// Global definitions visible to all methods and classes
+//============================================================================
+
+// hint the CPU to start loading an address into cache
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define PREFETCH(address)
+#endif
+
+// Bloom filter sizing: about 1% false positives at 10 bits and 6 probes per key
+const unsigned int BLOOM_BITS_PER_KEY = 10;
+const unsigned int BLOOM_PROBES = 6;
+
+// bids a program's filter is first sized for; it grows if more are loaded
+const size_t EXPECTED_BIDS = 20000;
+
+// bytes a bid file is read in at a time, so a load never holds the whole file
+const size_t POLL_CHUNK_BYTES = 1 << 20;
+
+// define a structure to hold bid information
+struct Bid {
+    string bidId; // unique identifier
+    string title;
+    string fund;
+    double amount;
+    Bid() {
+        amount = 0.0;
+    }
+};
+
+//============================================================================
+// Operation statistics (compiled in with -DBID_STATS)
+//============================================================================
+
+#ifdef BID_STATS
+
+/**
+ * Define a class containing data members and methods to
+ * implement an HDR-style latency histogram.
+ *
+ * Values below 128 ns get a bucket each; above that every power of two
+ * is split into 64 linear sub-buckets, so any recorded value is known
+ * to within 1/64 (about 1.6%) from 1 ns up to the full 64-bit range
+ * in a fixed 30 KB of counters.
+ */
+class LatencyHistogram {
+
+private:
+    static const int SUB_BITS = 7;
+    static const uint64_t SUB_COUNT = 1 << SUB_BITS;      // 128 exact buckets
+    static const uint64_t HALF_COUNT = SUB_COUNT / 2;     // 64 per power of two
+    static const int BUCKETS = (int)(SUB_COUNT + (64 - SUB_BITS + 1) * HALF_COUNT);
+
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maximum = 0;
+
+    static int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1) {
+            ++bit;
+        }
+        return bit;
+#endif
+    }
+
+    static int indexFor(uint64_t value) {
+        if (value < SUB_COUNT) {
+            return (int)value;
+        }
+        int shift = highestBit(value) - (SUB_BITS - 1);
+        return (int)(SUB_COUNT + (shift - 1) * HALF_COUNT + ((value >> shift) - HALF_COUNT));
+    }
+
+    // highest value that maps to a bucket
+    static uint64_t valueFor(int index) {
+        if ((uint64_t)index < SUB_COUNT) {
+            return index;
+        }
+        int shift = (int)((index - SUB_COUNT) / HALF_COUNT) + 1;
+        uint64_t sub = (index - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(BUCKETS, 0) {}
+
+    void Record(uint64_t nanos) {
+        counts[indexFor(nanos)]++;
+        total++;
+        sum += nanos;
+        maximum = max(maximum, nanos);
+    }
+
+    uint64_t Count() const {
+        return total;
+    }
+
+    uint64_t Max() const {
+        return maximum;
+    }
+
+    double Mean() const {
+        return total == 0 ? 0.0 : (double)sum / total;
+    }
+
+    uint64_t Percentile(double percentile) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(percentile / 100.0 * total + 0.5);
+        rank = max(rank, (uint64_t)1);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return min(valueFor(i), maximum);
+            }
+        }
+        return maximum;
+    }
+};
+
+// latency and counters for one kind of operation
+struct OperationStats {
+    LatencyHistogram latency;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t visited = 0;   // nodes or entries examined
+};
+
+// every instrumented operation on one container; search also counts
+// lookups that other operations (Remove, the index queries) make through it
+struct ContainerStats {
+    OperationStats insert;
+    OperationStats search;
+    OperationStats remove;
+    OperationStats traverse;
+    uint64_t allocations = 0;
+
+    /**
+     * Print a table of the statistics to the console
+     */
+    void Print(const string& container) {
+        const char* names[] = { "insert", "search", "remove", "traverse" };
+        OperationStats* operations[] = { &insert, &search, &remove, &traverse };
+        cout << container << " statistics (latency in ns)" << endl;
+        printf("  %-9s %10s %8s %8s %8s %10s %10s %10s %10s %12s\n", "operation", "count", "p50", "p99",
+            "p999", "max", "mean", "hits", "misses", "visited");
+        for (int i = 0; i < 4; ++i) {
+            const OperationStats& op = *operations[i];
+            printf("  %-9s %10llu %8llu %8llu %8llu %10llu %10.1f %10llu %10llu %12llu\n", names[i],
+                (unsigned long long)op.latency.Count(), (unsigned long long)op.latency.Percentile(50),
+                (unsigned long long)op.latency.Percentile(99), (unsigned long long)op.latency.Percentile(99.9),
+                (unsigned long long)op.latency.Max(), op.latency.Mean(), (unsigned long long)op.hits,
+                (unsigned long long)op.misses, (unsigned long long)op.visited);
+        }
+        cout << "  allocations: " << allocations << endl;
+    }
+
+    /**
+     * Write the statistics as a single JSON object
+     */
+    void WriteJson(ostream& out, const string& container) {
+        const char* names[] = { "insert", "search", "remove", "traverse" };
+        OperationStats* operations[] = { &insert, &search, &remove, &traverse };
+        out << "{\"container\":\"" << container << "\",\"allocations\":" << allocations << ",\"operations\":{";
+        for (int i = 0; i < 4; ++i) {
+            const OperationStats& op = *operations[i];
+            out << (i ? "," : "") << "\"" << names[i] << "\":{"
+                << "\"count\":" << op.latency.Count()
+                << ",\"p50_ns\":" << op.latency.Percentile(50)
+                << ",\"p99_ns\":" << op.latency.Percentile(99)
+                << ",\"p999_ns\":" << op.latency.Percentile(99.9)
+                << ",\"max_ns\":" << op.latency.Max()
+                << ",\"mean_ns\":" << op.latency.Mean()
+                << ",\"hits\":" << op.hits
+                << ",\"misses\":" << op.misses
+                << ",\"visited\":" << op.visited << "}";
+        }
+        out << "}}" << endl;
+    }
+};
+
+// records the lifetime of a scope into a histogram
+struct ScopedTimer {
+    LatencyHistogram& histogram;
+    chrono::steady_clock::time_point start;
+
+    ScopedTimer(LatencyHistogram& aHistogram) : histogram(aHistogram), start(chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram.Record((uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - start).count());
+    }
+};
+
+#define STATS_TIMER(operation) ScopedTimer statsTimer(stats.operation.latency)
+#define STATS_COUNT(counter) (stats.counter++)
+
+#else
+
+#define STATS_TIMER(operation)
+#define STATS_COUNT(counter)
+
+#endif
+
+//============================================================================
+// Bloom filter for negative lookups
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a blocked Bloom filter over bid ids.
+ *
+ * Each id hashes to one 64-byte block and sets BLOOM_PROBES bits inside
+ * it, so a query reads a single cache line. A clear bit proves the id was
+ * never added; all bits set only means it may have been. Removing a bid
+ * leaves its bits behind, which can cost a wasted search but never a
+ * wrong answer.
+ */
+class BloomFilter {
+
+private:
+    // one cache line of bits
+    struct Block {
+        uint64_t words[8];
+    };
+
+    vector<Block> blocks;
+    size_t capacity;
+
+    static uint64_t hashKey(const string& key);
+
+public:
+    BloomFilter(size_t expectedKeys);
+    void Add(const string& key);
+    bool MayContain(const string& key) const;
+    size_t Capacity() const {
+        return capacity;
+    }
+};
+
+/**
+ * Constructor sizing the filter at BLOOM_BITS_PER_KEY bits per key
+ *
+ * @param expectedKeys How many keys the filter should hold before its
+ *                     false positive rate starts to climb
+ */
+inline BloomFilter::BloomFilter(size_t expectedKeys) {
+    capacity = max(expectedKeys, (size_t)1);
+    blocks.resize((capacity * BLOOM_BITS_PER_KEY + 511) / 512);
+}
+
+/**
+ * Hash a key to 64 well mixed bits
+ *
+ * FNV-1a, then a splitmix64 finalizer so short numeric ids that differ
+ * in one digit still land far apart.
+ */
+inline uint64_t BloomFilter::hashKey(const string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+/**
+ * Add a key to the filter
+ *
+ * @param key The key to add
+ */
+inline void BloomFilter::Add(const string& key) {
+    uint64_t hash = hashKey(key);
+    Block& block = blocks[(hash >> 32) % blocks.size()];
+
+    // remix for the probes, nine bits apiece, so they are independent of the block choice
+    uint64_t probes = (hash ^ (hash >> 29)) * 0xff51afd7ed558ccdULL;
+    for (unsigned int i = 0; i < BLOOM_PROBES; ++i) {
+        unsigned int bit = (probes >> (9 * i)) & 511;
+        block.words[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+/**
+ * Check whether a key may have been added
+ *
+ * @param key The key to look for
+ * @return false if the key was definitely never added
+ */
+inline bool BloomFilter::MayContain(const string& key) const {
+    uint64_t hash = hashKey(key);
+    const Block& block = blocks[(hash >> 32) % blocks.size()];
+
+    uint64_t probes = (hash ^ (hash >> 29)) * 0xff51afd7ed558ccdULL;
+    for (unsigned int i = 0; i < BLOOM_PROBES; ++i) {
+        unsigned int bit = (probes >> (9 * i)) & 511;
+        if ((block.words[bit >> 6] & (1ULL << (bit & 63))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//============================================================================
+// Bid index interface
+//============================================================================
+
+// formats PrintAll and the batch export command can write
+enum ExportFormat {
+    EXPORT_TEXT,    // "id: title | amount | fund", as displayBid prints it
+    EXPORT_CSV,     // bidId,title,fund,amount with a header row
+    EXPORT_JSONL    // one JSON object per line
+};
+
+/**
+ * Compile-time check that a container can stand in for any other
+ *
+ * A bid index stores Bid records by id and provides Insert(bid),
+ * Search(bidId) returning a Bid (empty when absent), Remove(bidId) and
+ * PrintAll(). Loaders and drivers are templates over the concrete type,
+ * so every call is resolved at compile time; nothing is virtual.
+ */
+template <typename T, typename = void>
+struct IsBidIndex : false_type {};
+
+template <typename T>
+struct IsBidIndex<T, void_t<
+    decltype(declval<T&>().Insert(declval<const Bid&>())),
+    decltype(declval<T&>().Remove(declval<const string&>())),
+    decltype(declval<T&>().PrintAll()),
+    enable_if_t<is_convertible<decltype(declval<T&>().Search(declval<const string&>())), Bid>::value>>>
+    : true_type {};
+
+/**
+ * Compile-time check that a bid index also answers the batch queries:
+ * SearchByFund(fund) and SearchByAmount(low, high) returning the
+ * matching bids, Export(out, format) and Size()
+ */
+template <typename T, typename = void>
+struct IsQueryableBidIndex : false_type {};
+
+template <typename T>
+struct IsQueryableBidIndex<T, void_t<
+    enable_if_t<IsBidIndex<T>::value>,
+    decltype(declval<T&>().Export(declval<ostream&>(), EXPORT_TEXT)),
+    enable_if_t<is_convertible<decltype(declval<T&>().SearchByFund(declval<const string&>())), vector<Bid>>::value>,
+    enable_if_t<is_convertible<decltype(declval<T&>().SearchByAmount(0.0, 0.0)), vector<Bid>>::value>,
+    enable_if_t<is_convertible<decltype(declval<T&>().Size()), size_t>::value>>>
+    : true_type {};
+
+/**
+ * Hasher policy reproducing the labs' hash: the id read as a number
+ */
+struct AtoiHasher {
+    unsigned int operator()(const string& bidId) const {
+        return (unsigned int)atoi(bidId.c_str());
+    }
+};
+
+/**
+ * Hasher policy using 32-bit FNV-1a over the id's characters, which
+ * spreads ids that share a residue modulo the table size
+ */
+struct FnvHasher {
+    unsigned int operator()(const string& bidId) const {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : bidId) {
+            hash ^= c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a bid index over a plain vector, as a baseline for
+ * the other containers.
+ */
+class BidVector {
+
+private:
+    vector<Bid> bids;
+
+public:
+    void Insert(const Bid& bid) {
+        bids.push_back(bid);
+    }
+
+    Bid Search(const string& bidId) {
+        for (const Bid& bid : bids) {
+            if (bid.bidId == bidId) {
+                return bid;
+            }
+        }
+        return Bid();
+    }
+
+    void Remove(const string& bidId) {
+        for (vector<Bid>::iterator it = bids.begin(); it != bids.end(); ++it) {
+            if (it->bidId == bidId) {
+                bids.erase(it);
+                return;
+            }
+        }
+    }
+
+    void PrintAll();
+
+    size_t Size() {
+        return bids.size();
+    }
+};
+
+//============================================================================
+// Static methods used for testing
+//============================================================================
+
+/**
+ * Display the bid information to the console (std::out)
+ *
+ * @param bid struct containing the bid info
+ */
+inline void displayBid(Bid bid) {
+    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
+            << bid.fund << endl;
+    return;
+}
+
+/**
+ * Simple C function to convert a string to a double
+ * after stripping out unwanted char
+ *
+ * credit: http://stackoverflow.com/a/24875936
+ *
+ * @param ch The character to strip out
+ */
+inline double strToDouble(string str, char ch) {
+    str.erase(remove(str.begin(), str.end(), ch), str.end());
+    return atof(str.c_str());
+}
+
+//============================================================================
+// Incremental CSV loading
+//============================================================================
+
+/**
+ * Split one CSV row into fields, honouring double-quoted fields that
+ * hold commas and "" escapes
+ *
+ * @param row The row, without its line ending
+ * @return the fields in order
+ */
+inline vector<string> splitCsvRow(const string& row) {
+    vector<string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < row.size(); ++i) {
+        char c = row[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < row.size() && row[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            }
+            else if (c == '"') {
+                quoted = false;
+            }
+            else {
+                fields.back() += c;
+            }
+        }
+        else if (c == '"') {
+            quoted = true;
+        }
+        else if (c == ',') {
+            fields.push_back(string());
+        }
+        else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+/**
+ * Counters a load updates as it parses, readable from any thread
+ */
+struct LoadProgress {
+    atomic<uint64_t> bytesRead{0};
+    atomic<uint64_t> bytesTotal{0};
+    atomic<uint64_t> rows{0};
+    atomic<bool> cancelled{false};   // set to stop the load at the next row
+};
+
+/**
+ * Define a class containing data members and methods to
+ * implement a tail-follow loader for a growing bid CSV.
+ *
+ * The follower remembers which file it read and how many bytes of it
+ * it has consumed. It identifies the file by device and inode where the
+ * platform provides them. Each Poll stats the file and parses only the
+ * complete rows appended since the last call. A poll on an unchanged
+ * file costs one stat, so callers can poll before every command. A row
+ * still being written (no newline yet) is left for the next poll. If
+ * the file is replaced or shrinks, it is read again from the start.
+ */
+class BidFileFollower {
+
+private:
+    string path;
+    uint64_t offset = 0;     // bytes consumed, always at a row boundary
+    uint64_t device = 0;
+    uint64_t inode = 0;
+
+public:
+    BidFileFollower(const string& aPath) : path(aPath) {}
+
+    const string& Path() const {
+        return path;
+    }
+
+    uint64_t Offset() const {
+        return offset;
+    }
+
+    // position as "device inode offset path", for resuming after a restart
+    string State() const {
+        return to_string(device) + " " + to_string(inode) + " " + to_string(offset) + " " + path;
+    }
+
+    bool Restore(const string& state);
+    bool NeedsReload() const;
+
+    template <typename Index>
+    long Poll(Index* index, LoadProgress* progress = nullptr);
+};
+
+/**
+ * Tell whether the next Poll would read the file from the start: it
+ * has not been read yet, or it was replaced or truncated since
+ */
+inline bool BidFileFollower::NeedsReload() const {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+    return offset == 0 || (uint64_t)info.st_dev != device || (uint64_t)info.st_ino != inode
+        || (uint64_t)info.st_size < offset;
+}
+
+/**
+ * Resume from a position saved by State
+ *
+ * The next Poll still checks the file, so a replaced or truncated file
+ * is read again from the start.
+ *
+ * @param state The saved position
+ * @return false if the state is malformed or names another file
+ */
+inline bool BidFileFollower::Restore(const string& state) {
+    istringstream in(state);
+    uint64_t savedDevice, savedInode, savedOffset;
+    string savedPath;
+    if (!(in >> savedDevice >> savedInode >> savedOffset) || in.get() != ' ') {
+        return false;
+    }
+    getline(in, savedPath);
+    if (savedPath != path) {
+        return false;
+    }
+    device = savedDevice;
+    inode = savedInode;
+    offset = savedOffset;
+    return true;
+}
+
+/**
+ * Insert every complete row appended to the file since the last poll
+ *
+ * A poll cancelled through progress stops at the next row and leaves
+ * the follower where it was; the rows already inserted stay inserted.
+ *
+ * @param index The container to insert the new bids into
+ * @param progress Optional counters to update, and to check for cancellation
+ * @return the number of bids inserted, or -1 if the file cannot be read
+ */
+template <typename Index>
+long BidFileFollower::Poll(Index* index, LoadProgress* progress) {
+    static_assert(IsBidIndex<Index>::value, "BidFileFollower needs Insert, Search, Remove and PrintAll");
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return -1;
+    }
+
+    // a different file, or the same one truncated, starts over
+    uint64_t size = (uint64_t)info.st_size;
+    if ((uint64_t)info.st_dev != device || (uint64_t)info.st_ino != inode || size < offset) {
+        device = (uint64_t)info.st_dev;
+        inode = (uint64_t)info.st_ino;
+        offset = 0;
+    }
+    if (size == offset) {
+        return 0;
+    }
+
+    ifstream file(path.c_str(), ios::binary);
+    if (!file) {
+        return -1;
+    }
+    file.seekg((streamoff)offset);
+
+    // progress is measured against the bytes the file holds now
+    uint64_t unread = size - offset;
+    if (progress != nullptr) {
+        progress->bytesTotal = unread;
+    }
+
+    // read a chunk at a time; a row cut by the chunk boundary is carried
+    // into the next one, and only whole rows are consumed, so a partial
+    // last row waits for its newline
+    long inserted = 0;
+    uint64_t consumed = 0; // bytes of whole rows handled, from offset
+    string text;
+    while (unread > 0) {
+        size_t carried = text.size();
+        size_t wanted = (size_t)min<uint64_t>(unread, POLL_CHUNK_BYTES);
+        text.resize(carried + wanted);
+        file.read(&text[carried], (streamsize)wanted);
+        size_t got = (size_t)file.gcount();
+        text.resize(carried + got);
+        if (got == 0) {
+            break;
+        }
+        unread -= got;
+
+        size_t begin = 0;
+        size_t newline;
+        while ((newline = text.find('\n', begin)) != string::npos) {
+            if (progress != nullptr) {
+                if (progress->cancelled.load(memory_order_relaxed)) {
+                    return inserted;
+                }
+                progress->bytesRead.store(consumed + begin, memory_order_relaxed);
+            }
+            string row = text.substr(begin, newline - begin);
+            bool header = offset == 0 && consumed + begin == 0;
+            begin = newline + 1;
+            if (!row.empty() && row.back() == '\r') {
+                row.pop_back();
+            }
+            if (header || row.empty()) {
+                continue;
+            }
+
+            vector<string> fields = splitCsvRow(row);
+            if (fields.size() < 9) {
+                continue;
+            }
+            Bid bid;
+            bid.bidId = fields[1];
+            bid.title = fields[0];
+            bid.fund = fields[8];
+            bid.amount = strToDouble(fields[4], '$');
+            index->Insert(bid);
+            ++inserted;
+            if (progress != nullptr) {
+                progress->rows.fetch_add(1, memory_order_relaxed);
+            }
+        }
+        consumed += begin;
+        text.erase(0, begin);
+    }
+    if (progress != nullptr) {
+        progress->bytesRead = consumed;
+    }
+    offset += consumed;
+    return inserted;
+}
+
+//============================================================================
+// Versioned snapshots
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement multi-version publication of a bid index.
+ *
+ * Readers Pin the current version and keep a consistent view of it for
+ * as long as they hold the pointer, whatever is published meanwhile.
+ * A writer builds the next version off to the side and Publishes it
+ * with one atomic pointer swap, so readers never wait on a load. A
+ * version is freed by whoever drops the last pin on it.
+ */
+template <typename Index>
+class SnapshotStore {
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    atomic<shared_ptr<Index>> current;
+#else
+    shared_ptr<Index> current;   // only read and written through atomic_load/atomic_store
+#endif
+
+public:
+    explicit SnapshotStore(Index* initial) : current(shared_ptr<Index>(initial)) {}
+
+    shared_ptr<Index> Pin() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return current.load();
+#else
+        return atomic_load(&current);
+#endif
+    }
+
+    void Publish(Index* next) {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        current.store(shared_ptr<Index>(next));
+#else
+        atomic_store(&current, shared_ptr<Index>(next));
+#endif
+    }
+};
+
+//============================================================================
+// Background loading
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a bid file load that runs on its own thread.
+ *
+ * The worker builds a new index from the whole file while the menu
+ * keeps answering queries from the version already published. The
+ * thread that started the load collects the result, so the published
+ * version is only ever replaced by that thread. Progress can be read
+ * and the load cancelled at any time.
+ */
+template <typename Index>
+class BackgroundLoader {
+
+private:
+    thread worker;
+    LoadProgress progress;
+    BidFileFollower follower;       // the worker's own position in the file
+    Index* built = nullptr;         // set by the worker when it completes
+    long loaded = -1;
+    atomic<bool> finished{false};
+    chrono::steady_clock::time_point started;
+    double elapsed = 0.0;           // seconds the worker took, once finished
+
+public:
+    BackgroundLoader() : follower(string()) {}
+    ~BackgroundLoader();
+
+    template <typename Make>
+    void Start(const string& path, Make make);
+    long Collect(SnapshotStore<Index>& store, BidFileFollower& target);
+
+    bool Running() const {
+        return worker.joinable();
+    }
+
+    bool Finished() const {
+        return finished.load();
+    }
+
+    void Cancel() {
+        progress.cancelled = true;
+    }
+
+    bool Cancelled() const {
+        return progress.cancelled.load();
+    }
+
+    double Seconds() const {
+        if (finished.load()) {
+            return elapsed;
+        }
+        return chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    }
+
+    unsigned int Percent() const;
+    void PrintProgress(ostream& out) const;
+};
+
+/**
+ * Destructor, stopping a load still running
+ */
+template <typename Index>
+BackgroundLoader<Index>::~BackgroundLoader() {
+    if (worker.joinable()) {
+        Cancel();
+        worker.join();
+    }
+    delete built;
+}
+
+/**
+ * Start reading a whole bid file into a new index on the worker thread
+ *
+ * @param path The bid CSV to load
+ * @param make Returns a new, empty index
+ */
+template <typename Index>
+template <typename Make>
+void BackgroundLoader<Index>::Start(const string& path, Make make) {
+    follower = BidFileFollower(path);
+    progress.bytesRead = 0;
+    progress.bytesTotal = 0;
+    progress.rows = 0;
+    progress.cancelled = false;
+    finished = false;
+    started = chrono::steady_clock::now();
+
+    worker = thread([this, make]() {
+        unique_ptr<Index> next(make());
+        long count = follower.Poll(next.get(), &progress);
+        if (count >= 0 && !progress.cancelled.load()) {
+            built = next.release();
+            loaded = count;
+        }
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        finished = true;
+    });
+}
+
+/**
+ * Wait for the worker, then publish what it built and hand its position
+ * in the file over to target
+ *
+ * @return the number of bids loaded, or -1 if the load was cancelled or
+ *         the file could not be read; the published version is unchanged
+ */
+template <typename Index>
+long BackgroundLoader<Index>::Collect(SnapshotStore<Index>& store, BidFileFollower& target) {
+    worker.join();
+    if (built == nullptr) {
+        return -1;
+    }
+    store.Publish(built);
+    built = nullptr;
+    target = follower;
+    return loaded;
+}
+
+/**
+ * Return how much of the file the worker has parsed, 0 to 100
+ */
+template <typename Index>
+unsigned int BackgroundLoader<Index>::Percent() const {
+    uint64_t total = progress.bytesTotal.load();
+    return total == 0 ? 0 : (unsigned int)(progress.bytesRead.load() * 100 / total);
+}
+
+/**
+ * Print the rows and bytes loaded so far and the rate they came in at
+ */
+template <typename Index>
+void BackgroundLoader<Index>::PrintProgress(ostream& out) const {
+    double seconds = Seconds();
+    double megabytes = progress.bytesRead.load() / 1048576.0;
+    uint64_t rows = progress.rows.load();
+    out << "loading " << follower.Path() << ": " << Percent() << "% ("
+        << megabytes << " of " << progress.bytesTotal.load() / 1048576.0 << " MB, "
+        << rows << " rows) after " << seconds << " seconds, "
+        << (seconds > 0 ? rows / seconds : 0) << " rows/s, "
+        << (seconds > 0 ? megabytes / seconds : 0) << " MB/s" << endl;
+}
+
+/**
+ * Bring a snapshot store up to date with its source file, between commands
+ *
+ * A finished background load is published. A file that has to be read
+ * from the start, because it has not been read yet or was replaced or
+ * truncated, starts a background load of a whole new version while the
+ * current one keeps serving. Rows appended to the same file are inserted
+ * into the current version, which is only safe from the thread that also
+ * does the reading.
+ *
+ * @param store The published versions
+ * @param follower Where the published version has read the file up to
+ * @param loader Runs the whole-file loads
+ * @param make Returns a new, empty index
+ * @return the number of bids read, or -1 if the file cannot be read now;
+ *         a load that failed in the background has been reported already
+ */
+template <typename Index, typename Make>
+long followSnapshot(SnapshotStore<Index>& store, BidFileFollower& follower,
+    BackgroundLoader<Index>& loader, Make make) {
+    const string& path = follower.Path();
+
+    if (loader.Running()) {
+        if (!loader.Finished()) {
+            return 0;
+        }
+        long loaded = loader.Collect(store, follower);
+        if (loaded >= 0) {
+            double seconds = loader.Seconds();
+            cout << loaded << " bids loaded from " << path << " in " << seconds << " seconds ("
+                << (seconds > 0 ? loaded / seconds : 0) << " rows/s)" << endl;
+            return loaded;
+        }
+        if (loader.Cancelled()) {
+            cout << "load of " << path << " cancelled" << endl;
+        } else {
+            cout << "could not read " << path << endl;
+        }
+        return 0;
+    }
+
+    if (follower.NeedsReload()) {
+        cout << "Loading CSV file " << path << " in the background" << endl;
+        loader.Start(path, make);
+        return 0;
+    }
+
+    long appended = follower.Poll(store.Pin().get());
+    if (appended > 0) {
+        cout << appended << " new bids appended from " << path << endl;
+    }
+    return appended;
+}
+
+//============================================================================
+// Benchmark harness
+//============================================================================
+
+// options for a non-interactive benchmark run
+struct BenchmarkOptions {
+    unsigned int maxBids = 1000000;   // sweep 1k, 10k, ... up to this many bids
+    unsigned int repetitions = 5;     // measured runs per size, after one warmup
+    unsigned int operations = 10000;  // lookups and removals timed per run
+};
+
+// swallows traversal output so only the walk and formatting are timed
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) {
+        return c;
+    }
+};
+
+// keeps lookup results alive so the optimizer cannot drop them
+inline volatile double benchmarkSink = 0;
+
+/**
+ * Read the current resident set size, or 0 where it is not available
+ */
+inline size_t residentBytes() {
+#ifdef __linux__
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Nanoseconds on a monotonic clock
+ */
+inline long long nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Build a set of synthetic bids with unique, shuffled nine-digit ids
+ *
+ * @param count How many bids to make
+ * @param seed Seed for the generator, so every container sees the same data
+ */
+inline vector<Bid> makeBenchmarkBids(unsigned int count, unsigned int seed) {
+    static const char* words[] = { "Office", "Desk", "Laptop", "Chair", "Lamp", "Printer",
+        "Table", "Monitor", "Cabinet", "Truck", "Sedan", "Scanner", "Phone", "Shelf" };
+    static const char* funds[] = { "General Fund", "Enterprise", "Grant", "Capital", "Trust" };
+    mt19937 generator(seed);
+
+    // spread ids over the nine-digit range with a stride coprime to it,
+    // which keeps them unique without a set, then shuffle
+    vector<Bid> bids(count);
+    unsigned int id = generator() % 900000000;
+    for (unsigned int i = 0; i < count; ++i) {
+        id = (id + 282475249) % 900000000;
+        bids[i].bidId = to_string(100000000 + id);
+        bids[i].title = string(words[generator() % 14]) + " " + words[generator() % 14];
+        bids[i].fund = funds[generator() % 5];
+        bids[i].amount = (generator() % 100000) / 100.0;
+    }
+    shuffle(bids.begin(), bids.end(), generator);
+    return bids;
+}
+
+/**
+ * Print ns/op and latency percentiles for one operation
+ *
+ * @param container Name of the container measured
+ * @param bids Number of bids loaded
+ * @param operation Name of the operation measured
+ * @param samples Per-operation latencies in nanoseconds
+ */
+inline void reportSamples(const string& container, unsigned int bids, const string& operation, vector<double>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    size_t last = samples.size() - 1;
+    printf("%-22s %9u  %-12s %12.1f %10.0f %10.0f %10.0f\n", container.c_str(), bids, operation.c_str(),
+        total / samples.size(), samples[last * 50 / 100], samples[last * 99 / 100], samples[last * 999 / 1000]);
+}
+
+/**
+ * Drive one container through load, hit and miss lookup, traversal and
+ * removal at every size in the sweep
+ *
+ * Every container goes through the same code path, calling Insert,
+ * Search, Remove and PrintAll directly on the concrete type.
+ *
+ * @param name Label for the report
+ * @param options Sweep size, repetitions and operation counts
+ * @param linear True when lookups scan, which caps the operation count
+ * @param make Returns a new, empty Index sized for n bids
+ */
+template <typename Index, typename Make>
+void benchmarkIndex(const string& name, const BenchmarkOptions& options, bool linear, Make make) {
+    static_assert(IsBidIndex<Index>::value, "benchmarkIndex needs Insert, Search, Remove and PrintAll");
+    NullBuffer nullBuffer;
+
+    for (unsigned int bids = 1000; bids <= options.maxBids; bids *= 10) {
+        vector<Bid> data = makeBenchmarkBids(bids, bids);
+        vector<Bid> misses = makeBenchmarkBids(options.operations, bids + 1);
+        for (Bid& miss : misses) {
+            miss.bidId[0] = '0';  // real ids never start with 0
+        }
+
+        // scanning containers get fewer operations at large sizes
+        unsigned int operations = min(options.operations, bids);
+        if (linear) {
+            operations = max(50u, min(operations, (unsigned int)(50000000ULL / bids)));
+        }
+
+        vector<double> load, hit, miss, traversal, removal;
+        size_t memory = 0;
+        mt19937 generator(bids);
+
+        for (unsigned int run = 0; run <= options.repetitions; ++run) {
+            bool warmup = run == 0;
+
+            // load: one sample per run, averaged over every insert
+            size_t before = residentBytes();
+            Index* container = make(bids);
+            long long start = nowNanos();
+            for (const Bid& bid : data) {
+                container->Insert(bid);
+            }
+            long long elapsed = nowNanos() - start;
+            if (warmup) {
+                // measured on the first build, before freed memory gets reused
+                memory = residentBytes() - before;
+            }
+            else {
+                load.push_back((double)elapsed / bids);
+            }
+
+            // point lookups that hit, then ones that miss
+            for (unsigned int i = 0; i < operations; ++i) {
+                const Bid& target = data[generator() % bids];
+                start = nowNanos();
+                benchmarkSink = benchmarkSink + container->Search(target.bidId).amount;
+                elapsed = nowNanos() - start;
+                if (!warmup) {
+                    hit.push_back((double)elapsed);
+                }
+            }
+            for (unsigned int i = 0; i < operations; ++i) {
+                start = nowNanos();
+                benchmarkSink = benchmarkSink + container->Search(misses[i % misses.size()].bidId).amount;
+                elapsed = nowNanos() - start;
+                if (!warmup) {
+                    miss.push_back((double)elapsed);
+                }
+            }
+
+            // full traversal with the output thrown away, per bid
+            streambuf* console = cout.rdbuf(&nullBuffer);
+            start = nowNanos();
+            container->PrintAll();
+            elapsed = nowNanos() - start;
+            cout.rdbuf(console);
+            if (!warmup) {
+                traversal.push_back((double)elapsed / bids);
+            }
+
+            // remove a slice of the loaded bids
+            for (unsigned int i = 0; i < operations; ++i) {
+                start = nowNanos();
+                container->Remove(data[i].bidId);
+                elapsed = nowNanos() - start;
+                if (!warmup) {
+                    removal.push_back((double)elapsed);
+                }
+            }
+
+            delete container;
+        }
+
+        reportSamples(name, bids, "load", load);
+        reportSamples(name, bids, "search hit", hit);
+        reportSamples(name, bids, "search miss", miss);
+        reportSamples(name, bids, "traverse", traversal);
+        reportSamples(name, bids, "remove", removal);
+        if (memory > 0) {
+            printf("%-22s %9u  %-12s %12.1f bytes/bid (resident growth)\n", name.c_str(), bids, "memory", (double)memory / bids);
+        }
+        fflush(stdout);
+    }
+}
+
+/**
+ * Drive a default-constructed Index through the benchmark sweep
+ */
+template <typename Index>
+void benchmarkIndex(const string& name, const BenchmarkOptions& options, bool linear) {
+    benchmarkIndex<Index>(name, options, linear, [](unsigned int) { return new Index(); });
+}
+
+/**
+ * Compare looking ids up one at a time against SearchBatch at every
+ * size in the sweep
+ *
+ * @param name Label for the report
+ * @param options Sweep size, repetitions and operation counts
+ * @param make Returns a new, empty Index sized for n bids
+ */
+template <typename Index, typename Make>
+void benchmarkBatchSearch(const string& name, const BenchmarkOptions& options, Make make) {
+    for (unsigned int bids = 1000; bids <= options.maxBids; bids *= 10) {
+        vector<Bid> data = makeBenchmarkBids(bids, bids);
+        Index* index = make(bids);
+        for (const Bid& bid : data) {
+            index->Insert(bid);
+        }
+
+        // the same random hits for both methods
+        mt19937 generator(bids);
+        vector<string> bidIds(options.operations);
+        for (string& bidId : bidIds) {
+            bidId = data[generator() % bids].bidId;
+        }
+
+        vector<double> single, batch;
+        for (unsigned int run = 0; run <= options.repetitions; ++run) {
+            long long start = nowNanos();
+            for (const string& bidId : bidIds) {
+                benchmarkSink = benchmarkSink + index->Search(bidId).amount;
+            }
+            long long elapsed = nowNanos() - start;
+            if (run > 0) {
+                single.push_back((double)elapsed / bidIds.size());
+            }
+
+            start = nowNanos();
+            vector<Bid> found = index->SearchBatch(bidIds);
+            elapsed = nowNanos() - start;
+            benchmarkSink = benchmarkSink + found.back().amount;
+            if (run > 0) {
+                batch.push_back((double)elapsed / bidIds.size());
+            }
+        }
+        reportSamples(name, bids, "search loop", single);
+        reportSamples(name, bids, "search batch", batch);
+        fflush(stdout);
+        delete index;
+    }
+}
+
+/**
+ * Print the header for a benchmark report
+ */
+inline void printBenchmarkHeader(const BenchmarkOptions& options) {
+    printf("Benchmark: 1000 to %u bids, %u runs after 1 warmup, up to %u timed lookups/removals per run\n",
+        options.maxBids, options.repetitions, options.operations);
+    printf("load and traverse are ns per bid; the rest are ns per call\n");
+    printf("%-22s %9s  %-12s %12s %10s %10s %10s\n", "container", "bids", "operation", "mean ns", "p50", "p99", "p999");
+}
+
+/**
+ * Parse "--benchmark [maxBids] [repetitions]" style arguments
+ */
+inline BenchmarkOptions parseBenchmarkOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (argc > 2) {
+        options.maxBids = (unsigned int)strtoul(argv[2], nullptr, 10);
+    }
+    if (argc > 3) {
+        options.repetitions = (unsigned int)strtoul(argv[3], nullptr, 10);
+    }
+    return options;
+}
+
+//============================================================================
+// Report export
+//============================================================================
+
+// bids each worker formats into one buffer before the buffers are written
+const size_t EXPORT_CHUNK_BIDS = 16384;
+
+/**
+ * Append a bid to a line in the same form displayBid prints it
+ */
+inline void appendBid(string& line, const Bid& bid) {
+    char amount[32];
+    snprintf(amount, sizeof(amount), "%g", bid.amount);
+    line += bid.bidId;
+    line += ": ";
+    line += bid.title;
+    line += " | ";
+    line += amount;
+    line += " | ";
+    line += bid.fund;
+}
+
+/**
+ * Append a CSV field, quoted only when it holds a comma, quote or newline
+ */
+inline void appendCsvField(string& out, const string& field) {
+    if (field.find_first_of(",\"\r\n") == string::npos) {
+        out += field;
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+/**
+ * Append a JSON string literal, escaping quotes, backslashes and
+ * control characters
+ */
+inline void appendJsonString(string& out, const string& value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        }
+        else if ((unsigned char)c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", (unsigned int)(unsigned char)c);
+            out += escape;
+        }
+        else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+/**
+ * Append an amount in the shortest form that reads back as the same double
+ */
+inline void appendAmount(string& out, double amount) {
+    char digits[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    out.append(digits, to_chars(digits, digits + sizeof(digits), amount).ptr);
+#else
+    snprintf(digits, sizeof(digits), "%.17g", amount);
+    out += digits;
+#endif
+}
+
+/**
+ * Append one bid as a complete line in the given format
+ */
+inline void appendBidAs(string& out, const Bid& bid, ExportFormat format) {
+    switch (format) {
+    case EXPORT_TEXT:
+        appendBid(out, bid);
+        break;
+    case EXPORT_CSV:
+        appendCsvField(out, bid.bidId);
+        out += ',';
+        appendCsvField(out, bid.title);
+        out += ',';
+        appendCsvField(out, bid.fund);
+        out += ',';
+        appendAmount(out, bid.amount);
+        break;
+    case EXPORT_JSONL:
+        out += "{\"bidId\":";
+        appendJsonString(out, bid.bidId);
+        out += ",\"title\":";
+        appendJsonString(out, bid.title);
+        out += ",\"fund\":";
+        appendJsonString(out, bid.fund);
+        out += ",\"amount\":";
+        appendAmount(out, bid.amount);
+        out += '}';
+        break;
+    }
+    out += '\n';
+}
+
+/**
+ * Read an export format name: text, csv or jsonl
+ *
+ * @return false if the name is not one of them
+ */
+inline bool parseExportFormat(const string& name, ExportFormat& format) {
+    if (name == "text") {
+        format = EXPORT_TEXT;
+    } else if (name == "csv") {
+        format = EXPORT_CSV;
+    } else if (name == "jsonl") {
+        format = EXPORT_JSONL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Write bids to a stream in the given format
+ *
+ * The bids are cut into chunks of EXPORT_CHUNK_BIDS. Each round, one
+ * chunk per hardware thread is formatted into its own buffer in
+ * parallel, then the buffers are written in order with one write each,
+ * so the output matches a sequential export byte for byte.
+ *
+ * @param bids The bids to write, in output order
+ * @param out Where to write them
+ * @param format How to write each bid
+ */
+inline void exportBids(const vector<const Bid*>& bids, ostream& out, ExportFormat format) {
+    if (format == EXPORT_CSV) {
+        static const char header[] = "bidId,title,fund,amount\n";
+        out.write(header, sizeof(header) - 1);
+    }
+
+    size_t chunks = (bids.size() + EXPORT_CHUNK_BIDS - 1) / EXPORT_CHUNK_BIDS;
+    size_t workers = max<size_t>(1, min<size_t>(thread::hardware_concurrency(), chunks));
+    vector<string> buffers(workers);
+
+    auto formatChunk = [&](size_t worker, size_t chunk) {
+        string& buffer = buffers[worker];
+        buffer.clear();
+        size_t end = min(bids.size(), (chunk + 1) * EXPORT_CHUNK_BIDS);
+        for (size_t i = chunk * EXPORT_CHUNK_BIDS; i < end; ++i) {
+            appendBidAs(buffer, *bids[i], format);
+        }
+    };
+
+    for (size_t first = 0; first < chunks; first += workers) {
+        size_t round = min(workers, chunks - first);
+        vector<thread> helpers;
+        for (size_t worker = 1; worker < round; ++worker) {
+            helpers.emplace_back(formatChunk, worker, first + worker);
+        }
+        formatChunk(0, first);
+        for (thread& helper : helpers) {
+            helper.join();
+        }
+        for (size_t worker = 0; worker < round; ++worker) {
+            out.write(buffers[worker].data(), (streamsize)buffers[worker].size());
+        }
+    }
+    out.flush();
+}
+
+/**
+ * Print every bid in insertion order
+ */
+inline void BidVector::PrintAll() {
+    vector<const Bid*> pointers;
+    pointers.reserve(bids.size());
+    for (const Bid& bid : bids) {
+        pointers.push_back(&bid);
+    }
+    exportBids(pointers, cout, EXPORT_TEXT);
+}
+
+//============================================================================
+// Batch query mode
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement an output stream buffered in large blocks.
+ *
+ * Lines are built in place with Line() and committed with EndLine();
+ * the text reaches the stream a megabyte at a time instead of per line.
+ */
+class BufferedWriter {
+
+private:
+    ostream& out;
+    string buffer;
+    static const size_t FLUSH_AT = 1 << 20;
+
+public:
+    BufferedWriter(ostream& aOut) : out(aOut) {
+        buffer.reserve(FLUSH_AT + 4096);
+    }
+
+    ~BufferedWriter() {
+        Flush();
+    }
+
+    string& Line() {
+        return buffer;
+    }
+
+    void EndLine() {
+        buffer += '\n';
+        if (buffer.size() >= FLUSH_AT) {
+            Flush();
+        }
+    }
+
+    void Flush() {
+        out.write(buffer.data(), buffer.size());
+        out.flush();
+        buffer.clear();
+    }
+};
+
+/**
+ * Run a stream of operations against a bid index without prompts
+ *
+ * One operation per line; blank lines and lines starting with # are
+ * skipped. Results go to out through a BufferedWriter, and a throughput
+ * summary goes to cerr once the stream ends.
+ *
+ *   load <csv path>        insert the file's bids; loading the same path
+ *                          again inserts only rows appended since
+ *   find <bid id>          the bid, or "<bid id> not found"
+ *   remove <bid id>        remove one bid with that id, then
+ *                          "removed <bid id>" or "<bid id> not found"
+ *   range <low> <high>     every bid with an amount in [low, high]
+ *   aggregate [fund]       count, total, mean, min and max amount over
+ *                          one fund's bids, or over every bid
+ *   export <format> <path> write every bid to a file as text, csv or jsonl
+ *
+ * @param in The operations to run
+ * @param out Where to write the results
+ * @param index The container to run them against
+ * @return the number of lines that could not be run
+ */
+template <typename Index>
+unsigned long runBatch(istream& in, ostream& out, Index* index) {
+    static_assert(IsQueryableBidIndex<Index>::value,
+        "runBatch needs Insert, Search, Remove, PrintAll, SearchByFund, SearchByAmount, Export and Size");
+    BufferedWriter writer(out);
+    string& line = writer.Line();
+    unsigned long operations = 0, found = 0, errors = 0;
+    char number[96];
+    map<string, BidFileFollower> followers;
+
+    long long start = nowNanos();
+    string text;
+    while (getline(in, text)) {
+        if (!text.empty() && text.back() == '\r') {
+            text.pop_back();
+        }
+        size_t begin = text.find_first_not_of(" \t");
+        if (begin == string::npos || text[begin] == '#') {
+            continue;
+        }
+        ++operations;
+
+        // split the verb from the rest of the line, which may hold spaces
+        size_t verbEnd = text.find_first_of(" \t", begin);
+        string verb = text.substr(begin, verbEnd == string::npos ? string::npos : verbEnd - begin);
+        string argument;
+        if (verbEnd != string::npos) {
+            size_t argumentBegin = text.find_first_not_of(" \t", verbEnd);
+            if (argumentBegin != string::npos) {
+                argument = text.substr(argumentBegin);
+                argument.erase(argument.find_last_not_of(" \t") + 1);
+            }
+        }
+
+        if (verb == "find" && !argument.empty()) {
+            Bid bid = index->Search(argument);
+            if (bid.bidId.empty()) {
+                line += argument;
+                line += " not found";
+            }
+            else {
+                appendBid(line, bid);
+                ++found;
+            }
+            writer.EndLine();
+        }
+        else if (verb == "remove" && !argument.empty()) {
+            // Remove reports nothing, so tell a hit from a miss by the size
+            size_t before = (size_t)index->Size();
+            index->Remove(argument);
+            if ((size_t)index->Size() < before) {
+                line += "removed ";
+                line += argument;
+            }
+            else {
+                line += argument;
+                line += " not found";
+            }
+            writer.EndLine();
+        }
+        else if (verb == "range") {
+            double low, high;
+            istringstream bounds(argument);
+            if (!(bounds >> low >> high)) {
+                line += "error: range needs <low> <high>";
+                writer.EndLine();
+                ++errors;
+                continue;
+            }
+            vector<Bid> bids = index->SearchByAmount(low, high);
+            for (const Bid& bid : bids) {
+                appendBid(line, bid);
+                writer.EndLine();
+            }
+            found += bids.size();
+        }
+        else if (verb == "aggregate") {
+            vector<Bid> bids = argument.empty()
+                ? index->SearchByAmount(-numeric_limits<double>::infinity(), numeric_limits<double>::infinity())
+                : index->SearchByFund(argument);
+            double total = 0, low = 0, high = 0;
+            for (size_t i = 0; i < bids.size(); ++i) {
+                total += bids[i].amount;
+                low = i == 0 ? bids[i].amount : min(low, bids[i].amount);
+                high = i == 0 ? bids[i].amount : max(high, bids[i].amount);
+            }
+            snprintf(number, sizeof(number), "count %zu total %.2f mean %.2f min %.2f max %.2f", bids.size(),
+                total, bids.empty() ? 0.0 : total / bids.size(), low, high);
+            line += argument.empty() ? "all" : argument;
+            line += ": ";
+            line += number;
+            writer.EndLine();
+        }
+        else if (verb == "export") {
+            string formatName, path;
+            istringstream words(argument);
+            ExportFormat format;
+            if (!(words >> formatName >> path) || !parseExportFormat(formatName, format)) {
+                line += "error: export needs <text|csv|jsonl> <path>";
+                writer.EndLine();
+                ++errors;
+                continue;
+            }
+            ofstream file(path.c_str(), ios::binary);
+            index->Export(file, format);
+            if (!file) {
+                line += "error: could not write ";
+                line += path;
+                writer.EndLine();
+                ++errors;
+                continue;
+            }
+            line += "exported ";
+            line += to_string(index->Size());
+            line += " bids to ";
+            line += path;
+            writer.EndLine();
+        }
+        else if (verb == "load" && !argument.empty()) {
+            BidFileFollower& follower = followers.emplace(argument, BidFileFollower(argument)).first->second;
+            long loaded = follower.Poll(index);
+            if (loaded < 0) {
+                line += "error: could not read ";
+                line += argument;
+                writer.EndLine();
+                ++errors;
+                continue;
+            }
+            line += "loaded ";
+            line += to_string(loaded);
+            line += " bids from ";
+            line += argument;
+            line += ", ";
+            line += to_string(index->Size());
+            line += " in total";
+            writer.EndLine();
+        }
+        else {
+            line += "error: cannot run \"";
+            line += text.substr(begin);
+            line += "\"";
+            writer.EndLine();
+            ++errors;
+        }
+    }
+    writer.Flush();
+
+    double seconds = (nowNanos() - start) / 1e9;
+    cerr << "batch: " << operations << " operations (" << found << " bids returned, " << errors
+         << " errors) in " << seconds << " s, " << (seconds > 0 ? operations / seconds : 0) << " ops/s" << endl;
+    return errors;
+}
+
+/**
+ * Handle "--batch [operations file] [results file]" for a program
+ *
+ * Either file may be "-" or left out for stdin and stdout.
+ *
+ * @param index The container to run the operations against
+ * @return the exit code for main
+ */
+template <typename Index>
+int runBatchCommand(int argc, char* argv[], Index* index) {
+    ifstream opsFile;
+    ofstream resultsFile;
+    istream* in = &cin;
+    ostream* out = &cout;
+    if (argc > 2 && string(argv[2]) != "-") {
+        opsFile.open(argv[2]);
+        if (!opsFile) {
+            cerr << "Error: could not open " << argv[2] << endl;
+            return 1;
+        }
+        in = &opsFile;
+    }
+    if (argc > 3 && string(argv[3]) != "-") {
+        resultsFile.open(argv[3], ios::binary);
+        if (!resultsFile) {
+            cerr << "Error: could not open " << argv[3] << endl;
+            return 1;
+        }
+        out = &resultsFile;
+    }
+    return runBatch(*in, *out, index) == 0 ? 0 : 1;
+}
+
+#endif // BIDINDEX_HPP
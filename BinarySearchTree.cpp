@@ -6,10 +6,22 @@
 // Description : Lab 5-2 Binary Search Tree
 //============================================================================
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#include "BidIndex.hpp"
 
 using namespace std;
 
@@ -17,19 +29,8 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
-
-// define a structure to hold bid information
-struct Bid {
-    string bidId; // unique identifier
-    string title;
-    string fund;
-    double amount;
-    Bid() {
-        amount = 0.0;
-    }
-};
+// how many lookups SearchBatch keeps in flight at once
+const unsigned int BATCH_INTERLEAVE = 16;
 
 // Internal structure for tree node
 struct Node {
@@ -62,22 +63,52 @@ class BinarySearchTree {
 
 private:
     Node* root;
+    size_t size = 0;
+
+    // optional filter answering most lookups for absent ids without a descent
+    BloomFilter* bloom = nullptr;
+
+#ifdef BID_STATS
+    ContainerStats stats;
+#endif
+
+    // secondary indexes, kept in step with the tree on Insert/Remove
+    // unless the tree was built bare
+    bool secondaryIndexes = true;
+    map<string, multiset<string>> fundIndex;  // fund -> posting list of bid ids
+    multimap<double, string> amountIndex;   // amount -> bid id, ordered by amount
 
     void addNode(Node* node, Bid bid);
-    void inOrder(Node* node);
+    void indexBid(Bid bid);
+    void unindexBid(Bid bid);
+    void inOrder(Node* node, vector<const Bid*>& bids);
     void postOrder(Node* node);
     void preOrder(Node* node);
     Node* removeNode(Node* node, string bidId);
+    void rebuildBloom(size_t expectedBids);
 
 public:
     BinarySearchTree();
+    BinarySearchTree(bool withIndexes);
     virtual ~BinarySearchTree();
     void InOrder();
+    void PrintAll();
+    void Export(ostream& out, ExportFormat format);
     void PostOrder();
     void PreOrder();
     void Insert(Bid bid);
     void Remove(string bidId);
     Bid Search(string bidId);
+    vector<Bid> SearchBatch(const vector<string>& bidIds);
+    vector<Bid> SearchByFund(string fund);
+    vector<Bid> SearchByAmount(double low, double high);
+    void EnableBloomFilter(size_t expectedBids);
+    size_t Size();
+#ifdef BID_STATS
+    ContainerStats& Stats() {
+        return stats;
+    }
+#endif
 };
 
 /**
@@ -89,6 +120,16 @@ BinarySearchTree::BinarySearchTree() {
     root = nullptr;
 }
 
+/**
+ * Constructor choosing whether the fund and amount indexes are kept
+ *
+ * @param withIndexes false for a bare tree that answers fund and amount
+ *                    searches by walking every node
+ */
+BinarySearchTree::BinarySearchTree(bool withIndexes) : BinarySearchTree() {
+    secondaryIndexes = withIndexes;
+}
+
 /**
  * Destructor
  */
@@ -98,7 +139,7 @@ BinarySearchTree::~BinarySearchTree() {
     while (root != nullptr) {
         Remove(root->bid.bidId);
    }
-    
+    delete bloom;
 }
 
 /**
@@ -106,8 +147,29 @@ BinarySearchTree::~BinarySearchTree() {
  */
 void BinarySearchTree::InOrder() {
     // FixMe (3a): In order root
+    Export(cout, EXPORT_TEXT);
+}
+
+/**
+ * Write every bid, in bidId order, in one of the export formats
+ *
+ * @param out Where to write the bids
+ * @param format Text, CSV or JSON Lines
+ */
+void BinarySearchTree::Export(ostream& out, ExportFormat format) {
+    STATS_TIMER(traverse);
     // call inOrder fuction and pass root 
-    this->inOrder(root);
+    vector<const Bid*> bids;
+    bids.reserve(size);
+    this->inOrder(root, bids);
+    exportBids(bids, out, format);
+}
+
+/**
+ * Print every bid in order, under the name every bid index shares
+ */
+void BinarySearchTree::PrintAll() {
+    InOrder();
 }
 
 /**
@@ -134,53 +196,306 @@ void BinarySearchTree::PreOrder() {
  * Insert a bid
  */
 void BinarySearchTree::Insert(Bid bid) {
+    STATS_TIMER(insert);
     // FIXME (6a) Implement inserting a bid into the tree
     
     if (root == nullptr) {   // if root equarl to null ptr
        
         root = new Node(bid);    // root is equal to new node bid
+        STATS_COUNT(allocations);
     }
    
     else {    // else
         this->addNode(root, bid);   // add Node root and bid
     }
-      
+
+    // keep the fund and amount indexes in step with the tree
+    if (secondaryIndexes) {
+        indexBid(bid);
+    }
+
+    // grow the filter once the tree outgrows what it was sized for
+    size++;
+    if (bloom != nullptr) {
+        if (size > bloom->Capacity()) {
+            rebuildBloom(size * 2);
+        }
+        else {
+            bloom->Add(bid.bidId);
+        }
+    }
 }
 
 /**
  * Remove a bid
  */
 void BinarySearchTree::Remove(string bidId) {
+    STATS_TIMER(remove);
     // FIXME (7a) Implement removing a bid from the tree
-    this->removeNode(root, bidId);   // remove node root bidID
+    // look the bid up first so its index entries can be dropped too
+    Bid bid = Search(bidId);
+    if (bid.bidId.empty()) {
+        STATS_COUNT(remove.misses);
+        return;
+    }
+    STATS_COUNT(remove.hits);
+    if (secondaryIndexes) {
+        unindexBid(bid);
+    }
+    size--;
+    root = this->removeNode(root, bidId);   // remove node root bidID
 }
 
 /**
  * Search for a bid
  */
 Bid BinarySearchTree::Search(string bidId) {
+    STATS_TIMER(search);
     // FIXME (8) Implement searching the tree for a bid
+    if (bloom != nullptr && !bloom->MayContain(bidId)) {
+        STATS_COUNT(search.misses);
+        Bid bid;
+        return bid;
+    }
     Node* current = root;   // set current node equal to root
 
     // keep looping downwards until bottom reached or matching bidId found
     while (current != nullptr) {
+        STATS_COUNT(search.visited);
         if (current->bid.bidId.compare(bidId) == 0) {
+            STATS_COUNT(search.hits);
             return current->bid;    // if match found, return current bid
         }
         if (bidId.compare(current->bid.bidId) < 0) {
             current = current->left;     // if bid is smaller than current node then traverse left
         }
         else {
-            current = current->left;    // else larger so traverse right
+            current = current->right;    // else larger so traverse right
         }
     }      
 
         
        
+    STATS_COUNT(search.misses);
     Bid bid;
     return bid;
 }
 
+/**
+ * Search for many bid ids at once
+ *
+ * A single search stalls on every level, since it cannot read a child
+ * until the parent's compare is done. Here up to BATCH_INTERLEAVE
+ * searches are in flight. Each one takes a single step, prefetches the
+ * child it moves to and hands over to the next, so by the time a search
+ * comes round again its node is usually in cache.
+ *
+ * @param bidIds The bid ids to search for
+ * @return one bid per id, in the same order; empty where not found
+ */
+vector<Bid> BinarySearchTree::SearchBatch(const vector<string>& bidIds) {
+    // one in-flight search: which id, and the node it compares next
+    struct Lookup {
+        size_t index;
+        Node* node;
+    };
+
+    vector<Bid> bids(bidIds.size());
+    Lookup lookups[BATCH_INTERLEAVE];
+    size_t next = 0;
+    size_t active = 0;
+    while (active < BATCH_INTERLEAVE && next < bidIds.size()) {
+        lookups[active].index = next++;
+        lookups[active].node = root;
+        ++active;
+    }
+
+    while (active > 0) {
+        for (size_t i = 0; i < active; ) {
+            Lookup& lookup = lookups[i];
+            Node* node = lookup.node;
+            int order = node == nullptr ? 0 : node->bid.bidId.compare(bidIds[lookup.index]);
+
+            if (order != 0) {
+                // not there yet: step down and start loading the child
+                lookup.node = order > 0 ? node->left : node->right;
+                if (lookup.node != nullptr) {
+                    PREFETCH(lookup.node);
+                    PREFETCH(&lookup.node->left);
+                }
+                ++i;
+                continue;
+            }
+
+            // finished, found or fell off the tree: reuse the slot
+            if (node != nullptr) {
+                bids[lookup.index] = node->bid;
+            }
+            if (next < bidIds.size()) {
+                lookup.index = next++;
+                lookup.node = root;
+                ++i;
+            }
+            else {
+                lookup = lookups[--active];  // pull the last search into this slot
+            }
+        }
+    }
+    return bids;
+}
+
+/**
+ * Put a Bloom filter in front of Search and Remove
+ *
+ * Lookups for ids the filter has never seen return without descending
+ * the tree. The filter is sized for the bids already stored plus
+ * expectedBids, and is rebuilt at twice the size if the tree outgrows it.
+ *
+ * @param expectedBids How many more bids are expected
+ */
+void BinarySearchTree::EnableBloomFilter(size_t expectedBids) {
+    rebuildBloom(size + expectedBids);
+}
+
+/**
+ * Replace the Bloom filter with one sized for expectedBids, holding
+ * every stored bid
+ */
+void BinarySearchTree::rebuildBloom(size_t expectedBids) {
+    delete bloom;
+    bloom = new BloomFilter(expectedBids);
+
+    // walk with an explicit stack; a tree loaded in id order is a list deep
+    vector<Node*> pending;
+    if (root != nullptr) {
+        pending.push_back(root);
+    }
+    while (!pending.empty()) {
+        Node* node = pending.back();
+        pending.pop_back();
+        bloom->Add(node->bid.bidId);
+        if (node->left != nullptr) {
+            pending.push_back(node->left);
+        }
+        if (node->right != nullptr) {
+            pending.push_back(node->right);
+        }
+    }
+}
+
+/**
+ * Return the number of bids stored
+ */
+size_t BinarySearchTree::Size() {
+    return size;
+}
+
+/**
+ * Search for all bids posted against a fund
+ *
+ * @param fund The fund to look up
+ * @return the matching bids, in bid id order
+ */
+vector<Bid> BinarySearchTree::SearchByFund(string fund) {
+    vector<Bid> bids;
+
+    // a bare tree has no posting lists, so check every bid in id order
+    if (!secondaryIndexes) {
+        vector<const Bid*> all;
+        inOrder(root, all);
+        for (const Bid* bid : all) {
+            if (bid->fund == fund) {
+                bids.push_back(*bid);
+            }
+        }
+        return bids;
+    }
+
+    // look up the posting list and resolve each id through the tree
+    map<string, multiset<string>>::iterator it = fundIndex.find(fund);
+    if (it == fundIndex.end()) {
+        return bids;
+    }
+    for (const string& bidId : it->second) {
+        bids.push_back(Search(bidId));
+    }
+    return bids;
+}
+
+/**
+ * Search for all bids whose amount falls within a range
+ *
+ * @param low The lowest amount to include
+ * @param high The highest amount to include
+ * @return the matching bids, ordered by amount
+ */
+vector<Bid> BinarySearchTree::SearchByAmount(double low, double high) {
+    vector<Bid> bids;
+
+    // a bare tree has no amount index, so filter every bid and order the hits
+    if (!secondaryIndexes) {
+        vector<const Bid*> all;
+        inOrder(root, all);
+        for (const Bid* bid : all) {
+            if (bid->amount >= low && bid->amount <= high) {
+                bids.push_back(*bid);
+            }
+        }
+        stable_sort(bids.begin(), bids.end(), [](const Bid& a, const Bid& b) {
+            return a.amount < b.amount;
+        });
+        return bids;
+    }
+
+    // walk only the slice of the amount index inside [low, high]
+    multimap<double, string>::iterator it = amountIndex.lower_bound(low);
+    multimap<double, string>::iterator end = amountIndex.upper_bound(high);
+    for (; it != end; ++it) {
+        bids.push_back(Search(it->second));
+    }
+    return bids;
+}
+
+/**
+ * Add a bid to the fund and amount indexes
+ *
+ * @param bid The bid that was just inserted
+ */
+void BinarySearchTree::indexBid(Bid bid) {
+    fundIndex[bid.fund].insert(bid.bidId);
+    amountIndex.insert(make_pair(bid.amount, bid.bidId));
+}
+
+/**
+ * Drop a bid from the fund and amount indexes
+ *
+ * @param bid The bid that is being removed
+ */
+void BinarySearchTree::unindexBid(Bid bid) {
+    // remove one posting for this id from its fund
+    map<string, multiset<string>>::iterator fund = fundIndex.find(bid.fund);
+    if (fund != fundIndex.end()) {
+        multiset<string>& postings = fund->second;
+        multiset<string>::iterator pos = postings.find(bid.bidId);
+        if (pos != postings.end()) {
+            postings.erase(pos);
+        }
+        if (postings.empty()) {
+            fundIndex.erase(fund);
+        }
+    }
+
+    // remove one entry for this id at its amount
+    pair<multimap<double, string>::iterator, multimap<double, string>::iterator> range =
+        amountIndex.equal_range(bid.amount);
+    for (multimap<double, string>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == bid.bidId) {
+            amountIndex.erase(it);
+            break;
+        }
+    }
+}
+
 /**
  * Add a bid to some node (recursive)
  *
@@ -189,11 +504,13 @@ Bid BinarySearchTree::Search(string bidId) {
  */
 void BinarySearchTree::addNode(Node* node, Bid bid) {
     // FIXME (6b) Implement inserting a bid into the tree
+    STATS_COUNT(insert.visited);
 
     if (node->bid.bidId.compare(bid.bidId) > 0) {    // if node is larger then add to left
     
         if (node->left == nullptr) {   // if no left node
             node->left = new Node(bid);   // this node becomes left
+            STATS_COUNT(allocations);
     }
         else {   // else recurse down the left node
             this->addNode(node->left, bid);
@@ -203,21 +520,23 @@ void BinarySearchTree::addNode(Node* node, Bid bid) {
 
         if (node->right == nullptr) {   // if no right node
             node->right = new Node(bid);   // this node becomes right
+            STATS_COUNT(allocations);
         }
         else {   //else
             this->addNode(node->right, bid);   // recurse down the left node
         }
     }
 }
-void BinarySearchTree::inOrder(Node* node) {
+void BinarySearchTree::inOrder(Node* node, vector<const Bid*>& bids) {
       // FixMe (3b): Pre order root
     if (node != nullptr) {   //if node is not equal to null ptr
-        inOrder(node->left);   //InOrder not left
+        inOrder(node->left, bids);   //InOrder not left
+        STATS_COUNT(traverse.visited);
 
-        //output bidID, title, amount, fund
-        cout << node->bid.bidId << ": " << node->bid.title << " | " << node->bid.amount << " |" << node->bid.fund << endl;
+        //collect bidID, title, amount, fund for the export writer
+        bids.push_back(&node->bid);
 
-        inOrder(node->right);   //InOder right
+        inOrder(node->right, bids);   //InOder right
     }
 }
 void BinarySearchTree::postOrder(Node* node) {
@@ -303,71 +622,547 @@ Node* BinarySearchTree::removeNode(Node* node, string bidId) {
 
 
 //============================================================================
-// Static methods used for testing
+// Skip List class definition
 //============================================================================
 
 /**
- * Display the bid information to the console (std::out)
+ * Define a class containing data members and methods to
+ * implement a lock-free skip list ordered by bidId.
+ *
+ * Any number of threads may Insert, Remove, Search and walk the list
+ * at once. Each forward pointer is an atomic word whose low bit marks
+ * the node that owns it as logically deleted; Remove marks the tower
+ * top-down and later traversals unlink marked nodes with a CAS
+ * (Herlihy & Shavit, "The Art of Multiprocessor Programming", 14.4).
+ *
+ * Removed nodes stay allocated until the list is destroyed, because a
+ * concurrent reader may still be standing on them. Bid ids are unique:
+ * inserting an id that is already present is a no-op.
+ */
+class SkipList {
+
+private:
+    static const int MAX_LEVEL = 24;  // comfortable for tens of millions of bids
+
+    struct Node {
+        Bid bid;
+        int topLevel;
+        bool isTail;
+        atomic<uintptr_t>* next;   // topLevel + 1 marked forward pointers
+        Node* allocNext;           // chain of every node ever allocated
+
+        Node(Bid aBid, int aTopLevel, bool tail) {
+            bid = aBid;
+            topLevel = aTopLevel;
+            isTail = tail;
+            next = new atomic<uintptr_t>[aTopLevel + 1];
+            for (int i = 0; i <= aTopLevel; ++i) {
+                next[i].store(0);
+            }
+            allocNext = nullptr;
+        }
+
+        ~Node() {
+            delete[] next;
+        }
+    };
+
+    Node* head;
+    Node* tail;
+    atomic<Node*> allocated;  // freed in the destructor
+
+    static Node* pointer(uintptr_t word) {
+        return (Node*)(word & ~(uintptr_t)1);
+    }
+    static bool marked(uintptr_t word) {
+        return (word & 1) != 0;
+    }
+    static bool before(Node* node, const string& bidId) {
+        return !node->isTail && node->bid.bidId.compare(bidId) < 0;
+    }
+
+    static int randomLevel();
+    void track(Node* node);
+    bool find(const string& bidId, Node** preds, Node** succs);
+
+public:
+    SkipList();
+    virtual ~SkipList();
+    void InOrder();
+    void PrintAll();
+    void Export(ostream& out, ExportFormat format);
+    bool Insert(Bid bid);
+    bool Remove(string bidId);
+    Bid Search(string bidId);
+
+    /**
+     * Visit every live bid in bidId order
+     *
+     * Safe to call while other threads mutate the list; the walk sees
+     * each bid that stays present for its whole duration.
+     *
+     * @param visit Called with each bid
+     */
+    template <typename Visitor>
+    void ForEach(Visitor visit) {
+        Node* node = pointer(head->next[0].load());
+        while (!node->isTail) {
+            uintptr_t succ = node->next[0].load();
+            if (!marked(succ)) {
+                visit(node->bid);
+            }
+            node = pointer(succ);
+        }
+    }
+};
+
+/**
+ * Default constructor
+ */
+SkipList::SkipList() {
+    head = new Node(Bid(), MAX_LEVEL, false);
+    tail = new Node(Bid(), MAX_LEVEL, true);
+    for (int level = 0; level <= MAX_LEVEL; ++level) {
+        head->next[level].store((uintptr_t)tail);
+    }
+    allocated.store(nullptr);
+}
+
+/**
+ * Destructor
+ */
+SkipList::~SkipList() {
+    // every node, live or removed, is on the allocation chain
+    Node* node = allocated.load();
+    while (node != nullptr) {
+        Node* temp = node;
+        node = node->allocNext;
+        delete temp;
+    }
+    delete head;
+    delete tail;
+}
+
+/**
+ * Pick a tower height, each level half as likely as the one below
+ */
+int SkipList::randomLevel() {
+    static thread_local mt19937 generator(random_device{}());
+    unsigned int bits = generator();
+    int level = 0;
+    while ((bits & 1) && level < MAX_LEVEL) {
+        bits >>= 1;
+        ++level;
+    }
+    return level;
+}
+
+/**
+ * Push a freshly published node onto the allocation chain
+ */
+void SkipList::track(Node* node) {
+    Node* first = allocated.load();
+    do {
+        node->allocNext = first;
+    } while (!allocated.compare_exchange_weak(first, node));
+}
+
+/**
+ * Locate the predecessor and successor of a bidId at every level,
+ * unlinking any marked nodes met along the way
  *
- * @param bid struct containing the bid info
+ * @param bidId The bid id to locate
+ * @param preds Receives the last node before bidId at each level
+ * @param succs Receives the first node at or after bidId at each level
+ * @return true if an unmarked node holding bidId was found
  */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-            << bid.fund << endl;
-    return;
+bool SkipList::find(const string& bidId, Node** preds, Node** succs) {
+retry:
+    Node* pred = head;
+    Node* curr = nullptr;
+    for (int level = MAX_LEVEL; level >= 0; --level) {
+        curr = pointer(pred->next[level].load());
+        while (true) {
+            uintptr_t succ = curr->next[level].load();
+            while (marked(succ)) {
+                // snip out the deleted node; start over if pred changed under us
+                uintptr_t expected = (uintptr_t)curr;
+                if (!pred->next[level].compare_exchange_strong(expected, (uintptr_t)pointer(succ))) {
+                    goto retry;
+                }
+                curr = pointer(pred->next[level].load());
+                succ = curr->next[level].load();
+            }
+            if (before(curr, bidId)) {
+                pred = curr;
+                curr = pointer(succ);
+            }
+            else {
+                break;
+            }
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return !curr->isTail && curr->bid.bidId.compare(bidId) == 0;
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Insert a bid
  *
- * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
+ * @param bid The bid to insert
+ * @return false if the bid id was already present
  */
-void loadBids(string csvPath, BinarySearchTree* bst) {
-    cout << "Loading CSV file " << csvPath << endl;
+bool SkipList::Insert(Bid bid) {
+    Node* preds[MAX_LEVEL + 1];
+    Node* succs[MAX_LEVEL + 1];
+    int topLevel = randomLevel();
+
+    while (true) {
+        if (find(bid.bidId, preds, succs)) {
+            return false;
+        }
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+        Node* node = new Node(bid, topLevel, false);
+        for (int level = 0; level <= topLevel; ++level) {
+            node->next[level].store((uintptr_t)succs[level]);
+        }
 
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+        // linking the bottom level is what makes the bid visible
+        uintptr_t expected = (uintptr_t)succs[0];
+        if (!preds[0]->next[0].compare_exchange_strong(expected, (uintptr_t)node)) {
+            delete node;   // never published, safe to free
+            continue;
+        }
+        track(node);
+
+        // then build the rest of the tower, re-finding on contention
+        for (int level = 1; level <= topLevel; ++level) {
+            while (true) {
+                uintptr_t own = node->next[level].load();
+                if (marked(own)) {
+                    return true;   // already being removed, stop linking
+                }
+                if (pointer(own) != succs[level]
+                    && !node->next[level].compare_exchange_strong(own, (uintptr_t)succs[level])) {
+                    continue;
+                }
+                expected = (uintptr_t)succs[level];
+                if (preds[level]->next[level].compare_exchange_strong(expected, (uintptr_t)node)) {
+                    break;
+                }
+                find(bid.bidId, preds, succs);
+                if (succs[0] != node) {
+                    return true;   // removed while we were linking
+                }
+            }
+        }
+        return true;
     }
-    cout << "" << endl;
+}
+
+/**
+ * Remove a bid
+ *
+ * @param bidId The bid id to remove
+ * @return true if this call removed the bid
+ */
+bool SkipList::Remove(string bidId) {
+    Node* preds[MAX_LEVEL + 1];
+    Node* succs[MAX_LEVEL + 1];
 
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+    if (!find(bidId, preds, succs)) {
+        return false;
+    }
+    Node* victim = succs[0];
 
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+    // mark the upper levels top-down so no new links land on the victim
+    for (int level = victim->topLevel; level >= 1; --level) {
+        uintptr_t succ = victim->next[level].load();
+        while (!marked(succ)) {
+            victim->next[level].compare_exchange_weak(succ, succ | 1);
+        }
+    }
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+    // whoever marks the bottom level owns the removal
+    uintptr_t succ = victim->next[0].load();
+    while (true) {
+        if (marked(succ)) {
+            return false;
+        }
+        if (victim->next[0].compare_exchange_strong(succ, succ | 1)) {
+            find(bidId, preds, succs);   // physically unlink it
+            return true;
+        }
+    }
+}
 
-            // push this bid to the end
-            bst->Insert(bid);
+/**
+ * Search for a bid, never writing to the list
+ *
+ * @param bidId The bid id to search for
+ */
+Bid SkipList::Search(string bidId) {
+    Node* pred = head;
+    Node* curr = nullptr;
+    for (int level = MAX_LEVEL; level >= 0; --level) {
+        curr = pointer(pred->next[level].load());
+        while (true) {
+            uintptr_t succ = curr->next[level].load();
+            while (marked(succ)) {   // step over deleted nodes
+                curr = pointer(succ);
+                succ = curr->next[level].load();
+            }
+            if (before(curr, bidId)) {
+                pred = curr;
+                curr = pointer(succ);
+            }
+            else {
+                break;
+            }
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
     }
+
+    if (!curr->isTail && curr->bid.bidId.compare(bidId) == 0 && !marked(curr->next[0].load())) {
+        return curr->bid;
+    }
+    Bid bid;
+    return bid;
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Traverse the list in bidId order
+ */
+void SkipList::InOrder() {
+    Export(cout, EXPORT_TEXT);
+}
+
+/**
+ * Write every live bid, in bidId order, in one of the export formats
+ *
+ * Nodes are only freed by the destructor, so the collected bids stay
+ * valid even if other threads remove them meanwhile.
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param out Where to write the bids
+ * @param format Text, CSV or JSON Lines
+ */
+void SkipList::Export(ostream& out, ExportFormat format) {
+    vector<const Bid*> bids;
+    ForEach([&bids](const Bid& bid) {
+        bids.push_back(&bid);
+    });
+    exportBids(bids, out, format);
+}
+
+/**
+ * Print every bid in order, under the name every bid index shares
+ */
+void SkipList::PrintAll() {
+    InOrder();
+}
+
+//============================================================================
+// Static methods used for testing
+//============================================================================
+
+/**
+ * Build a synthetic bid whose id sorts in numeric order
  *
- * @param ch The character to strip out
+ * @param n The number to base the bid id on
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+Bid makeTestBid(unsigned int n) {
+    char id[16];
+    snprintf(id, sizeof(id), "%09u", n);
+    Bid bid;
+    bid.bidId = id;
+    bid.title = "Test bid " + bid.bidId;
+    bid.fund = "Test";
+    bid.amount = n % 1000;
+    return bid;
+}
+
+/**
+ * Hammer the skip list with concurrent writers and readers, check
+ * that it stayed consistent, then compare its throughput against a
+ * bare BinarySearchTree (no fund, amount or Bloom indexes, which the
+ * skip list does not keep either) guarded by a single mutex
+ *
+ * The skip list ignores an insert of an id it already holds, so the
+ * tree skips those too and both stay the same size; the skipped
+ * inserts are counted and reported.
+ *
+ * @param threadCount The number of threads to run
+ * @param opsPerThread The operations each thread performs
+ * @return true if the skip list stayed consistent
+ */
+bool runConcurrencyTest(unsigned int threadCount, unsigned int opsPerThread) {
+    cout << "Stress test: " << threadCount << " writers, " << threadCount
+         << " readers, " << opsPerThread << " inserts each" << endl;
+
+    // writers insert disjoint keys and remove every fourth one again,
+    // while readers walk the list and check it never goes out of order
+    SkipList list;
+    atomic<bool> writing(true);
+    atomic<unsigned long> orderErrors(0);
+    atomic<unsigned long> walks(0);
+    vector<thread> writers;
+    vector<thread> readers;
+
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        readers.push_back(thread([&]() {
+            while (writing.load()) {
+                string last;
+                list.ForEach([&](const Bid& bid) {
+                    if (!last.empty() && bid.bidId.compare(last) <= 0) {
+                        orderErrors++;
+                    }
+                    last = bid.bidId;
+                });
+                walks++;
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < threadCount; ++t) {
+        writers.push_back(thread([&, t]() {
+            for (unsigned int i = 0; i < opsPerThread; ++i) {
+                list.Insert(makeTestBid(i * threadCount + t));
+                if (i % 4 == 0) {
+                    list.Remove(makeTestBid(i * threadCount + t).bidId);
+                }
+            }
+        }));
+    }
+    for (thread& writer : writers) {
+        writer.join();
+    }
+    writing.store(false);
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    // every surviving key must be present, in order, and nothing else
+    unsigned long missing = 0;
+    unsigned long unexpected = 0;
+    for (unsigned int n = 0; n < threadCount * opsPerThread; ++n) {
+        bool found = !list.Search(makeTestBid(n).bidId).bidId.empty();
+        bool expected = (n / threadCount) % 4 != 0;
+        if (expected && !found) {
+            missing++;
+        }
+        else if (!expected && found) {
+            unexpected++;
+        }
+    }
+    unsigned long count = 0;
+    string last;
+    list.ForEach([&](const Bid& bid) {
+        if (!last.empty() && bid.bidId.compare(last) <= 0) {
+            orderErrors++;
+        }
+        last = bid.bidId;
+        count++;
+    });
+
+    bool passed = missing == 0 && unexpected == 0 && orderErrors.load() == 0
+        && count == (unsigned long)threadCount * opsPerThread - (unsigned long)threadCount * ((opsPerThread + 3) / 4);
+    cout << "  " << walks.load() << " concurrent walks, " << orderErrors.load() << " order errors, "
+         << missing << " missing, " << unexpected << " unexpected, " << count << " bids left" << endl;
+    cout << "  " << (passed ? "PASSED" : "FAILED") << endl;
+
+    // throughput: 50% search, 30% insert, 20% remove over a shared key space
+    const unsigned int keySpace = 1 << 20;
+    cout << "Throughput (50% search, 30% insert, 20% remove):" << endl;
+    for (unsigned int threads = 1; threads <= threadCount; threads *= 2) {
+        SkipList skipList;
+        BinarySearchTree tree(false);
+        mutex treeLock;
+
+        // start both half full, in random order so the tree stays shallow
+        mt19937 generator(42);
+        for (unsigned int i = 0; i < keySpace / 2; ++i) {
+            Bid bid = makeTestBid(generator() % keySpace);
+            if (skipList.Insert(bid)) {
+                tree.Insert(bid);
+            }
+        }
+
+        for (int structure = 0; structure < 2; ++structure) {
+            atomic<unsigned long> duplicates(0);
+            vector<thread> workers;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for (unsigned int t = 0; t < threads; ++t) {
+                workers.push_back(thread([&, t]() {
+                    mt19937 rng(t + 1);
+                    for (unsigned int i = 0; i < opsPerThread; ++i) {
+                        unsigned int op = rng() % 10;
+                        Bid bid = makeTestBid(rng() % keySpace);
+                        if (structure == 0) {
+                            if (op < 5) skipList.Search(bid.bidId);
+                            else if (op < 8) {
+                                if (!skipList.Insert(bid)) duplicates++;
+                            }
+                            else skipList.Remove(bid.bidId);
+                        }
+                        else {
+                            lock_guard<mutex> guard(treeLock);
+                            if (op < 5) tree.Search(bid.bidId);
+                            else if (op < 8) {
+                                // Insert would store a second copy; look first, as the skip list does
+                                if (tree.Search(bid.bidId).bidId.empty()) tree.Insert(bid);
+                                else duplicates++;
+                            }
+                            else tree.Remove(bid.bidId);
+                        }
+                    }
+                }));
+            }
+            for (thread& worker : workers) {
+                worker.join();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            unsigned long left = 0;
+            if (structure == 0) {
+                skipList.ForEach([&](const Bid&) { left++; });
+            }
+            else {
+                left = (unsigned long)tree.Size();
+            }
+            cout << "  " << threads << " thread(s), " << (structure == 0 ? "lock-free skip list:  " : "mutex + bare tree:    ")
+                 << (threads * (double)opsPerThread) / seconds / 1e6 << " Mops/s, "
+                 << duplicates.load() << " duplicate inserts skipped, "
+                 << left << " bids left" << endl;
+        }
+    }
+    return passed;
+}
+
+/**
+ * Create the empty tree each load of the bid file starts from
+ */
+BinarySearchTree* newBidTree() {
+    return new BinarySearchTree();
+}
+
+/**
+ * Run the benchmark sweep over the binary search tree and the skip list
+ */
+void runBenchmarks(const BenchmarkOptions& options) {
+    printBenchmarkHeader(options);
+
+    benchmarkIndex<BinarySearchTree>("BinarySearchTree", options, false);
+
+    benchmarkIndex<BinarySearchTree>("BinarySearchTree+bloom", options, false,
+        [](unsigned int bids) {
+            BinarySearchTree* tree = new BinarySearchTree();
+            tree->EnableBloomFilter(bids);
+            return tree;
+        });
+
+    benchmarkIndex<SkipList>("SkipList", options, false);
+
+    // per-key ns for interleaved lookups against the one-at-a-time loop
+    benchmarkBatchSearch<BinarySearchTree>("BinarySearchTree", options,
+        [](unsigned int) { return new BinarySearchTree(); });
 }
 
 /**
@@ -375,6 +1170,27 @@ double strToDouble(string str, char ch) {
  */
 int main(int argc, char* argv[]) {
 
+    // non-interactive benchmark sweep
+    if (argc >= 2 && string(argv[1]) == "--benchmark") {
+        runBenchmarks(parseBenchmarkOptions(argc, argv));
+        return 0;
+    }
+
+    // non-interactive concurrency stress test: --stress [threads] [operations per thread]
+    if (argc >= 2 && string(argv[1]) == "--stress") {
+        unsigned int threads = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10)
+                                        : max(2u, thread::hardware_concurrency());
+        unsigned int operations = argc > 3 ? (unsigned int)strtoul(argv[3], nullptr, 10) : 100000;
+        return runConcurrencyTest(max(1u, threads), max(1u, operations)) ? 0 : 1;
+    }
+
+    // non-interactive batch of operations: --batch [operations] [results]
+    if (argc >= 2 && string(argv[1]) == "--batch") {
+        BinarySearchTree tree;
+        tree.EnableBloomFilter(EXPECTED_BIDS);
+        return runBatchCommand(argc, argv, &tree);
+    }
+
     // process command line arguments
     string csvPath, bidKey;
     switch (argc) {
@@ -394,39 +1210,70 @@ int main(int argc, char* argv[]) {
     // Define a timer variable
     clock_t ticks;
 
-    // Define a binary search tree to hold all bids
-    BinarySearchTree* bst;
-    bst = new BinarySearchTree();
+    // Define a binary search tree to hold all bids; each reload publishes
+    // a new version and every command pins the one it works on
+    SnapshotStore<BinarySearchTree> trees(newBidTree());
     Bid bid;
 
+    // Load Bids reads the file once, then follows rows appended to it
+    BidFileFollower follower(csvPath);
+    BackgroundLoader<BinarySearchTree> loader;
+    bool following = false;
+
     int choice = 0;
     while (choice != 9) {
         cout << "Menu:" << endl;
-        cout << "  1. Load Bids" << endl;
+        cout << "  1. Load Bids";
+        if (loader.Running()) {
+            cout << " (" << loader.Percent() << "% loaded)";
+        }
+        cout << endl;
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Find Bids by Fund" << endl;
+        cout << "  6. Find Bids by Amount" << endl;
+        cout << "  7. Concurrency Stress Test" << endl;
+#ifdef BID_STATS
+        cout << "  8. Show Statistics" << endl;
+#endif
         cout << "  9. Exit" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
-        switch (choice) {
-
-        case 1:
-            
-            // Initialize a timer variable before loading bids
-            ticks = clock();
+        // publish a finished load, or pick up rows appended while waiting
+        if (following && choice != 1) {
+            followSnapshot(trees, follower, loader, newBidTree);
+        }
+        shared_ptr<BinarySearchTree> bst = trees.Pin();
 
-            // Complete the method call to load the bids
-            loadBids(csvPath, bst);
+        switch (choice) {
 
-            //cout << bst->Size() << " bids read" << endl;
+        case 1: {
+
+            // a load still running reports its progress and may be cancelled
+            if (loader.Running() && !loader.Finished()) {
+                loader.PrintProgress(cout);
+                cout << "Cancel the load? (y/n) ";
+                string answer;
+                cin >> answer;
+                if (answer == "y" || answer == "Y") {
+                    loader.Cancel();
+                }
+                break;
+            }
 
-            // Calculate elapsed time and display result
-            ticks = clock() - ticks; // current clock ticks minus starting clock ticks
-            cout << "time: " << ticks << " clock ticks" << endl;
-            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            // the first load reads the whole file in the background while
+            // the menu keeps serving the current version, later ones only
+            // appended rows
+            long loaded = followSnapshot(trees, follower, loader, newBidTree);
+            if (loaded < 0) {
+                cout << "could not read " << csvPath << endl;
+                break;
+            }
+            following = true;
             break;
+        }
 
         case 2:
             bst->InOrder();
@@ -451,8 +1298,64 @@ int main(int argc, char* argv[]) {
             break;
 
         case 4:
+            // the tree being loaded would not see the removal
+            if (loader.Running()) {
+                cout << "a load is in progress, remove the bid once it finishes" << endl;
+                break;
+            }
             bst->Remove(bidKey);
             break;
+
+        case 5: {
+            string fund;
+            cout << "Enter fund: ";
+            cin.ignore();
+            getline(cin, fund);
+
+            ticks = clock();
+            vector<Bid> matches = bst->SearchByFund(fund);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
+        }
+
+        case 6: {
+            double low, high;
+            cout << "Enter lowest amount: ";
+            cin >> low;
+            cout << "Enter highest amount: ";
+            cin >> high;
+
+            ticks = clock();
+            vector<Bid> matches = bst->SearchByAmount(low, high);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
+        }
+
+        case 7:
+            runConcurrencyTest(max(2u, thread::hardware_concurrency()), 100000);
+            break;
+
+#ifdef BID_STATS
+        case 8: {
+            bst->Stats().Print("BinarySearchTree");
+            ofstream json("BinarySearchTree_stats.json");
+            bst->Stats().WriteJson(json, "BinarySearchTree");
+            cout << "statistics written to BinarySearchTree_stats.json" << endl;
+            break;
+        }
+#endif
         }
     }
 
@@ -0,0 +1,507 @@
+//============================================================================
+// Name        : DataGenerator.cpp
+// Author      : Danny Forte
+// Version     : 1.0
+// Copyright   : Copyright  2023 SNHU COCE
+// Description : Synthetic eBid and course catalog files for load testing
+//============================================================================
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BidIndex.hpp"
+
+using namespace std;
+
+//============================================================================
+// Global definitions visible to all methods and classes
+//============================================================================
+
+// bid ids are nine digits like the real eBid export
+const unsigned long long ID_BASE = 100000000ULL;
+const unsigned long long ID_SPACE = 900000000ULL;
+
+// the lab HashTable's default bucket count, used by the "collide" order
+const unsigned int DEFAULT_TABLE_SIZE = 179;
+
+// options shared by both generators
+struct Options {
+    string kind;                  // "bids" or "courses"
+    unsigned long long rows = 0;  // how many lines to write
+    string path;                  // output file
+    string order = "random";      // key distribution
+    string shape = "random";      // prerequisite graph shape (courses)
+    unsigned int maxPrereqs = 3;  // most prerequisites per course
+    unsigned int levels = 8;      // depth of the "layered" shape
+    unsigned int dupFactor = 8;   // copies of each id for "duplicates"
+    double skew = 1.1;            // Zipf exponent for "skewed"
+    double dangling = 0.0;        // fraction of prerequisites that name no course
+    unsigned int seed = 1;
+};
+
+//============================================================================
+// Key distributions
+//============================================================================
+
+/**
+ * Produce the bid id for row i under the requested order
+ *
+ * sorted, reverse and random ids are unique; random walks the id space
+ * with a multiplier coprime to it, a bijection that needs no memory.
+ * skewed draws ids from a Zipf distribution so a few ids repeat very
+ * often; duplicates gives every id exactly dupFactor consecutive rows
+ * (the last id fewer when rows is not a multiple), which generateBids
+ * then writes in shuffled order;
+ * collide makes every id a multiple of the lab hash table's default
+ * size so they all land in one bucket.
+ *
+ * @param i Row number
+ * @param options Requested distribution
+ * @param generator Random source for the non-deterministic orders
+ */
+unsigned long long bidIdFor(unsigned long long i, const Options& options, mt19937_64& generator) {
+    unsigned long long n = options.rows;
+
+    if (options.order == "sorted") {
+        return ID_BASE + i * (ID_SPACE / max(n, 1ULL));
+    }
+    if (options.order == "reverse") {
+        return ID_BASE + (n - 1 - i) * (ID_SPACE / max(n, 1ULL));
+    }
+    if (options.order == "skewed") {
+        // inverse CDF of a continuous power law, rank 1 is the hottest id
+        double u = uniform_real_distribution<double>(0.0, 1.0)(generator);
+        double s = options.skew == 1.0 ? 1.0001 : options.skew;
+        double top = pow((double)n, 1.0 - s);
+        unsigned long long rank = (unsigned long long)pow((top - 1.0) * u + 1.0, 1.0 / (1.0 - s));
+        return ID_BASE + (rank * 282475249ULL) % ID_SPACE;
+    }
+    if (options.order == "duplicates") {
+        unsigned long long group = i / max(options.dupFactor, 1u);
+        return ID_BASE + group * 282475249ULL % ID_SPACE;
+    }
+    if (options.order == "collide") {
+        unsigned long long first = (ID_BASE + DEFAULT_TABLE_SIZE - 1) / DEFAULT_TABLE_SIZE;
+        unsigned long long slots = ID_SPACE / DEFAULT_TABLE_SIZE - 1;
+        return (first + (i * 282475249ULL) % slots) * DEFAULT_TABLE_SIZE;
+    }
+
+    // random: unique ids in a scrambled order
+    return ID_BASE + (i * 282475249ULL + 12345) % ID_SPACE;
+}
+
+//============================================================================
+// Bid file generator
+//============================================================================
+
+/**
+ * Write an eBid monthly sales file in the nine-column layout
+ * BidFileFollower reads: [0] title, [1] id, [4] winning bid, [8] fund
+ *
+ * @param options Row count, output path, order and seed
+ * @return false if the file could not be opened or written
+ */
+bool generateBids(const Options& options) {
+    static const char* adjectives[] = { "Used", "Surplus", "Refurbished", "Steel", "Oak", "Large",
+        "Small", "Portable", "Electric", "Industrial", "Vintage", "Ergonomic" };
+    static const char* items[] = { "Desk", "Laptop", "Office Chair", "Filing Cabinet", "Monitor",
+        "Printer", "Pickup Truck", "Sedan", "Bookcase", "Projector", "Generator", "Lawn Mower",
+        "Conference Table", "Tablet", "Forklift", "Server Rack" };
+    static const char* departments[] = { "General Services", "Public Works", "Parks", "Police",
+        "Fire", "Library", "Transit", "Water" };
+    static const char* funds[] = { "General Fund", "Enterprise", "Grant", "Capital Projects",
+        "Special Revenue", "Internal Service", "Trust" };
+
+    ofstream file(options.path.c_str(), ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    BufferedWriter out(file);
+    mt19937_64 generator(options.seed);
+
+    // duplicates ids are laid out in groups, so write those rows shuffled
+    vector<unsigned long long> order;
+    if (options.order == "duplicates") {
+        order.resize(options.rows);
+        for (unsigned long long i = 0; i < options.rows; ++i) {
+            order[i] = i;
+        }
+        shuffle(order.begin(), order.end(), generator);
+    }
+
+    string& line = out.Line();
+    line += "ArticleTitle,ArticleID,Department,CloseDate,WinningBid,InventoryID,VehicleID,ReceiptNumber,Fund";
+    out.EndLine();
+
+    // amounts are log-normal: mostly small, with a long tail of big-ticket items
+    lognormal_distribution<double> amount(4.0, 1.4);
+    char number[64];
+
+    for (unsigned long long i = 0; i < options.rows; ++i) {
+        line += adjectives[generator() % 12];
+        line += ' ';
+        line += items[generator() % 16];
+        line += ',';
+        line += to_string(bidIdFor(order.empty() ? i : order[i], options, generator));
+        line += ',';
+        line += departments[generator() % 8];
+        snprintf(number, sizeof(number), ",%u/%u/20%02u,$%.2f,",
+            (unsigned int)(generator() % 12 + 1), (unsigned int)(generator() % 28 + 1),
+            (unsigned int)(generator() % 8 + 16), amount(generator));
+        line += number;
+        line += to_string(i + 1);             // InventoryID
+        line += ',';
+        if (generator() % 4 == 0) {           // VehicleID, only some items have one
+            line += to_string(generator() % 90000 + 10000);
+        }
+        line += ',';
+        line += to_string(generator() % 9000000 + 1000000);  // ReceiptNumber
+        line += ',';
+        line += funds[generator() % 7];
+        out.EndLine();
+    }
+    out.Flush();
+    return file.good();
+}
+
+//============================================================================
+// Course file generator
+//============================================================================
+
+/**
+ * Make the course number for course i: a four-letter department plus a
+ * three-digit number, with synthetic departments once the real ones run out
+ */
+string courseNumberFor(unsigned long long i) {
+    static const char* departments[] = { "CSCI", "MATH", "PHYS", "ENGL", "HIST", "BIOL", "CHEM", "ECON" };
+    unsigned long long department = i / 900;
+    string code;
+    if (department < 8) {
+        code = departments[department];
+    }
+    else {
+        department -= 8;
+        for (int k = 0; k < 4; ++k) {
+            code.insert(code.begin(), (char)('A' + department % 26));
+            department /= 26;
+        }
+    }
+    return code + to_string(100 + i % 900);
+}
+
+/**
+ * For the "cyclic" shape, the later course that course i requires when i
+ * opens a block of a hundred courses; that course requires i in turn, so
+ * every block holds at least one cycle
+ *
+ * @param i Course number
+ * @param n Number of courses
+ * @return the partner course, or i when course i has none
+ */
+unsigned long long cyclePartner(unsigned long long i, unsigned long long n) {
+    if (i % 100 != 0 || i + 1 >= n) {
+        return i;
+    }
+    unsigned long long span = min(99ULL, n - i - 1);
+    return i + 1 + (i / 100 * 7919) % span;
+}
+
+/**
+ * Write a course catalog in the layout loadDataStructure reads:
+ * number, title, then any prerequisite numbers
+ *
+ * Prerequisites always point at earlier courses, which keeps the
+ * graph acyclic, except for the "cyclic" shape which adds back edges:
+ * a few at random, plus one guaranteed cycle per hundred courses.
+ * Rows are shuffled unless the order is "sorted".
+ *
+ * @param options Course count, output path, shape and seed
+ * @return false if the file could not be opened or written
+ */
+bool generateCourses(const Options& options) {
+    static const char* topics[] = { "Foundations", "Programming", "Data Structures", "Algorithms",
+        "Systems", "Theory", "Networks", "Databases", "Analysis", "Design", "Methods", "Seminar" };
+
+    ofstream file(options.path.c_str(), ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    BufferedWriter out(file);
+    mt19937_64 generator(options.seed);
+    unsigned long long n = options.rows;
+    unsigned long long perLevel = max(n / max(options.levels, 1u), 1ULL);
+
+    // row order
+    vector<unsigned long long> order(n);
+    for (unsigned long long i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    if (options.order == "reverse") {
+        reverse(order.begin(), order.end());
+    }
+    else if (options.order != "sorted") {
+        shuffle(order.begin(), order.end(), generator);
+    }
+
+    string& line = out.Line();
+    for (unsigned long long row = 0; row < n; ++row) {
+        unsigned long long i = order[row];
+        line += courseNumberFor(i);
+        line += ',';
+        line += topics[i % 12];
+        line += " ";
+        line += to_string(i / 12 + 1);
+
+        // pick prerequisites according to the shape
+        vector<unsigned long long> prereqs;
+        if (options.shape == "chain") {
+            if (i > 0) {
+                prereqs.push_back(i - 1);
+            }
+        }
+        else if (options.shape == "tree") {
+            if (i > 0) {
+                prereqs.push_back((i - 1) / 2);
+            }
+        }
+        else if (options.shape == "layered") {
+            unsigned long long level = i / perLevel;
+            if (level > 0) {
+                unsigned int count = (unsigned int)(generator() % (options.maxPrereqs + 1));
+                for (unsigned int k = 0; k < count; ++k) {
+                    prereqs.push_back((level - 1) * perLevel + generator() % perLevel);
+                }
+            }
+        }
+        else if (options.shape == "random" || options.shape == "cyclic") {
+            if (i > 0) {
+                unsigned int count = (unsigned int)(generator() % (options.maxPrereqs + 1));
+                for (unsigned int k = 0; k < count; ++k) {
+                    prereqs.push_back(generator() % i);
+                }
+            }
+            // roughly one course in a hundred also requires a later one
+            if (options.shape == "cyclic" && i + 1 < n && generator() % 100 == 0) {
+                prereqs.push_back(i + 1 + generator() % (n - i - 1));
+            }
+        }
+
+        for (unsigned long long prereq : prereqs) {
+            line += ',';
+            if (options.dangling > 0
+                && uniform_real_distribution<double>(0.0, 1.0)(generator) < options.dangling) {
+                line += "ZZZZ" + to_string(generator() % 900 + 100);  // names no real course
+            }
+            else {
+                line += courseNumberFor(prereq);
+            }
+        }
+
+        // both halves of the block's guaranteed cycle, never made dangling
+        if (options.shape == "cyclic") {
+            unsigned long long partner = cyclePartner(i, n);
+            if (partner != i) {
+                line += ',';
+                line += courseNumberFor(partner);
+            }
+            unsigned long long opener = i > 0 ? (i - 1) / 100 * 100 : 0;
+            if (i > 0 && cyclePartner(opener, n) == i) {
+                line += ',';
+                line += courseNumberFor(opener);
+            }
+        }
+        out.EndLine();
+    }
+    out.Flush();
+    return file.good();
+}
+
+//============================================================================
+// Command line
+//============================================================================
+
+/**
+ * Print usage to the console
+ */
+void printUsage() {
+    cout << "Usage:" << endl;
+    cout << "  DataGenerator bids <rows> <file> [--order sorted|reverse|random|skewed|duplicates|collide]" << endl;
+    cout << "                [--skew s] [--dup-factor k] [--seed n]" << endl;
+    cout << "  DataGenerator courses <count> <file> [--shape none|chain|tree|layered|random|cyclic]" << endl;
+    cout << "                [--order sorted|reverse|random] [--max-prereqs k] [--levels n]" << endl;
+    cout << "                [--dangling fraction] [--seed n]" << endl;
+}
+
+/**
+ * Parse a whole non-negative integer no larger than limit
+ *
+ * @param text The text given on the command line
+ * @param limit The largest value accepted
+ * @param value Receives the number
+ * @return false unless all of text is a number in range
+ */
+bool parseCount(const string& text, unsigned long long limit, unsigned long long& value) {
+    if (text.empty() || text[0] < '0' || text[0] > '9') {
+        return false;  // strtoull would accept a sign or leading blanks
+    }
+    char* end = nullptr;
+    errno = 0;
+    value = strtoull(text.c_str(), &end, 10);
+    return errno == 0 && *end == '\0' && value <= limit;
+}
+
+/**
+ * Parse a whole finite number in [low, high]
+ *
+ * @param text The text given on the command line
+ * @param low The smallest value accepted
+ * @param high The largest value accepted
+ * @param value Receives the number
+ * @return false unless all of text is a number in range
+ */
+bool parseNumber(const string& text, double low, double high, double& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return *end == '\0' && isfinite(value) && value >= low && value <= high;
+}
+
+/**
+ * Check a value against the names a flag accepts
+ *
+ * @param value The value given on the command line
+ * @param allowed The accepted names, separated by '|'
+ */
+bool isOneOf(const string& value, const string& allowed) {
+    size_t start = 0;
+    while (start <= allowed.size()) {
+        size_t end = allowed.find('|', start);
+        if (end == string::npos) {
+            end = allowed.size();
+        }
+        if (allowed.compare(start, end - start, value) == 0) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+/**
+ * The one and only main() method
+ *
+ * @param arg[1] "bids" or "courses"
+ * @param arg[2] number of rows to write
+ * @param arg[3] output file
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        printUsage();
+        return 1;
+    }
+
+    Options options;
+    options.kind = argv[1];
+    options.path = argv[3];
+    if (!parseCount(argv[2], ULLONG_MAX, options.rows) || options.rows == 0) {
+        cerr << "Invalid row count " << argv[2] << endl;
+        printUsage();
+        return 1;
+    }
+
+    for (int i = 4; i < argc; i += 2) {
+        string flag = argv[i];
+        if (i + 1 == argc) {
+            cerr << "Missing value for " << flag << endl;
+            printUsage();
+            return 1;
+        }
+        string value = argv[i + 1];
+
+        // counts that size something must be at least 1; a seed or prerequisite cap may be 0
+        unsigned long long count = 0;
+        bool valid = true;
+        if (flag == "--order") {
+            options.order = value;
+        }
+        else if (flag == "--shape") {
+            options.shape = value;
+        }
+        else if (flag == "--max-prereqs") {
+            valid = parseCount(value, UINT_MAX - 1, count);
+            options.maxPrereqs = (unsigned int)count;
+        }
+        else if (flag == "--levels") {
+            valid = parseCount(value, UINT_MAX, count) && count > 0;
+            options.levels = (unsigned int)count;
+        }
+        else if (flag == "--dup-factor") {
+            valid = parseCount(value, UINT_MAX, count) && count > 0;
+            options.dupFactor = (unsigned int)count;
+        }
+        else if (flag == "--skew") {
+            valid = parseNumber(value, 0.0, 100.0, options.skew) && options.skew > 0;
+        }
+        else if (flag == "--dangling") {
+            valid = parseNumber(value, 0.0, 1.0, options.dangling);
+        }
+        else if (flag == "--seed") {
+            valid = parseCount(value, UINT_MAX, count);
+            options.seed = (unsigned int)count;
+        }
+        else {
+            cerr << "Unknown option " << flag << endl;
+            printUsage();
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Invalid value " << value << " for " << flag << endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    // reject names the generators would otherwise quietly treat as "random"
+    string orders = options.kind == "bids" ? "sorted|reverse|random|skewed|duplicates|collide"
+                                           : "sorted|reverse|random";
+    if (!isOneOf(options.order, orders)) {
+        cerr << "Unknown order " << options.order << endl;
+        printUsage();
+        return 1;
+    }
+    if (!isOneOf(options.shape, "none|chain|tree|layered|random|cyclic")) {
+        cerr << "Unknown shape " << options.shape << endl;
+        printUsage();
+        return 1;
+    }
+
+    bool written;
+    if (options.kind == "bids") {
+        written = generateBids(options);
+    }
+    else if (options.kind == "courses") {
+        written = generateCourses(options);
+    }
+    else {
+        printUsage();
+        return 1;
+    }
+    if (!written) {
+        cerr << "Error: could not write " << options.path << endl;
+        return 1;
+    }
+
+    cout << "Wrote " << options.rows << " " << options.kind << " to " << options.path << endl;
+    return 0;
+}
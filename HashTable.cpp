@@ -7,12 +7,28 @@
 //============================================================================
 
 #include <algorithm>
+#include <cctype>
 #include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring> // memcpy
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
 #include <string> // atoi
 #include <time.h>
+#include <vector>
 
-#include "CSVparser.hpp"
+#ifdef _WIN32
+#include <io.h> // _commit
+#else
+#include <unistd.h> // fsync
+#endif
+
+#include "BidIndex.hpp"
 
 using namespace std;
 
@@ -22,29 +38,547 @@ using namespace std;
 
 const unsigned int DEFAULT_SIZE = 179;
 
+// how far the measured lookup cost may stray from uniform hashing before
+// the table reports itself as degenerate
+const double HEALTH_WARN_RATIO = 1.5;
+
+// how many keys ahead SearchBatch requests buckets from memory
+const unsigned int BATCH_PREFETCH_DISTANCE = 8;
+
+// log records buffered before one write + fsync covers them all
+const unsigned int WAL_GROUP_RECORDS = 256;
+
+// logged mutations between checkpoints, which bounds recovery replay; a
+// larger table waits for as many mutations as the last checkpoint held
+// bids, so the O(n) checkpoint stays amortized O(1) per mutation
+const uint64_t CHECKPOINT_INTERVAL = 50000;
+
 // forward declarations
-double strToDouble(string str, char ch);
+string foldCase(string str);
+
+//============================================================================
+// Prefix Trie class definition
+//============================================================================
+
+/**
+ * Define a class containing data members and methods to
+ * implement a compressed radix trie for prefix completion.
+ *
+ * Each edge carries a run of characters rather than a single one, and
+ * children are kept sorted by their first character, so a depth-first
+ * walk below the prefix yields completions in lexicographic order and
+ * can stop as soon as it has k of them.
+ */
+class PrefixTrie {
+
+private:
+    struct Node {
+        string label;            // characters on the edge into this node
+        vector<Node*> children;  // sorted by label[0]
+        unsigned int count;      // keys ending here, 0 if not a key
+        string value;            // text handed back for this key
+
+        Node() {
+            count = 0;
+        }
+    };
+
+    Node* root;
+
+    static Node* findChild(Node* node, char c, size_t* pos);
+    void collect(Node* node, vector<string>& out, unsigned int k);
+    void destroy(Node* node);
+
+public:
+    PrefixTrie();
+    virtual ~PrefixTrie();
+    void Insert(string key, string value);
+    void Remove(string key);
+    vector<string> Complete(string prefix, unsigned int k);
+};
+
+/**
+ * Default constructor
+ */
+PrefixTrie::PrefixTrie() {
+    root = new Node();
+}
+
+/**
+ * Destructor
+ */
+PrefixTrie::~PrefixTrie() {
+    destroy(root);
+}
+
+/**
+ * Free a node and everything below it (recursive)
+ */
+void PrefixTrie::destroy(Node* node) {
+    for (Node* child : node->children) {
+        destroy(child);
+    }
+    delete node;
+}
+
+/**
+ * Find the child whose edge starts with c
+ *
+ * @param node The node whose children are searched
+ * @param c The first character of the edge
+ * @param pos Receives the index the child has, or would be inserted at
+ * @return the child, or nullptr if there is none
+ */
+PrefixTrie::Node* PrefixTrie::findChild(Node* node, char c, size_t* pos) {
+    vector<Node*>& children = node->children;
+    vector<Node*>::iterator it = lower_bound(children.begin(), children.end(), c,
+        [](Node* child, char ch) { return child->label[0] < ch; });
+    *pos = it - children.begin();
+    if (it != children.end() && (*it)->label[0] == c) {
+        return *it;
+    }
+    return nullptr;
+}
+
+/**
+ * Insert a key, splitting an edge where the key diverges from it
+ *
+ * @param key The key to insert
+ * @param value The text to return when the key is completed
+ */
+void PrefixTrie::Insert(string key, string value) {
+    Node* node = root;
+    size_t i = 0;
+
+    while (i < key.size()) {
+        size_t pos;
+        Node* child = findChild(node, key[i], &pos);
+
+        // nothing shares this character, hang the rest of the key off a new leaf
+        if (child == nullptr) {
+            Node* leaf = new Node();
+            leaf->label = key.substr(i);
+            node->children.insert(node->children.begin() + pos, leaf);
+            node = leaf;
+            break;
+        }
+
+        // measure how much of the edge the key shares
+        size_t common = 0;
+        while (common < child->label.size() && i + common < key.size()
+            && child->label[common] == key[i + common]) {
+            ++common;
+        }
+
+        // key diverges part way along the edge, so split it
+        if (common < child->label.size()) {
+            Node* middle = new Node();
+            middle->label = child->label.substr(0, common);
+            child->label = child->label.substr(common);
+            middle->children.push_back(child);
+            node->children[pos] = middle;
+            child = middle;
+        }
+
+        node = child;
+        i += common;
+    }
+
+    // first value stored for a key wins
+    if (node->count == 0) {
+        node->value = value;
+    }
+    node->count++;
+}
+
+/**
+ * Remove one occurrence of a key
+ *
+ * When the last occurrence goes, nodes left with no key and no
+ * children are pruned on the way back up, and a keyless node left
+ * with a single child is merged into it, so the trie stays as small
+ * as if the key had never been inserted.
+ *
+ * @param key The key to remove
+ */
+void PrefixTrie::Remove(string key) {
+    Node* node = root;
+    size_t i = 0;
+    vector<pair<Node*, size_t>> path;  // parent and child index of each edge walked
+
+    while (i < key.size()) {
+        size_t pos;
+        Node* child = findChild(node, key[i], &pos);
+        if (child == nullptr || key.compare(i, child->label.size(), child->label) != 0) {
+            return;
+        }
+        path.push_back(make_pair(node, pos));
+        node = child;
+        i += child->label.size();
+    }
+
+    if (node->count == 0) {
+        return;
+    }
+    node->count--;
+    if (node->count > 0) {
+        return;
+    }
+    node->value.clear();
+
+    // drop nodes that no longer lead to any key
+    while (!path.empty() && node->count == 0 && node->children.empty()) {
+        Node* parent = path.back().first;
+        parent->children.erase(parent->children.begin() + path.back().second);
+        delete node;
+        node = parent;
+        path.pop_back();
+    }
+
+    // a keyless node with one child no longer branches, fold its edge into the child's
+    if (!path.empty() && node->count == 0 && node->children.size() == 1) {
+        Node* child = node->children[0];
+        child->label = node->label + child->label;
+        path.back().first->children[path.back().second] = child;
+        delete node;
+    }
+}
+
+/**
+ * Return the first k keys that start with a prefix
+ *
+ * @param prefix The prefix typed so far
+ * @param k The most completions to return
+ * @return the values of the matching keys, in key order
+ */
+vector<string> PrefixTrie::Complete(string prefix, unsigned int k) {
+    vector<string> out;
+    Node* node = root;
+    size_t i = 0;
+
+    // walk down the prefix; the last edge may run past its end
+    while (i < prefix.size()) {
+        size_t pos;
+        node = findChild(node, prefix[i], &pos);
+        if (node == nullptr) {
+            return out;
+        }
+        size_t length = min(node->label.size(), prefix.size() - i);
+        if (node->label.compare(0, length, prefix, i, length) != 0) {
+            return out;
+        }
+        i += length;
+    }
+
+    collect(node, out, k);
+    return out;
+}
+
+/**
+ * Gather values below a node in key order until k are found (recursive)
+ */
+void PrefixTrie::collect(Node* node, vector<string>& out, unsigned int k) {
+    if (out.size() >= k) {
+        return;
+    }
+    if (node->count > 0) {
+        out.push_back(node->value);
+    }
+    for (Node* child : node->children) {
+        collect(child, out, k);
+        if (out.size() >= k) {
+            return;
+        }
+    }
+}
+
+//============================================================================
+// Write-ahead log
+//============================================================================
+
+// WAL record types
+const unsigned char WAL_INSERT = 1;
+const unsigned char WAL_REMOVE = 2;
+const unsigned char WAL_SOURCE = 3;     // where the source CSV has been read up to
+
+const char CHECKPOINT_MAGIC[8] = { 'B', 'I', 'D', 'C', 'K', 'P', 'T', '1' };
+
+/**
+ * CRC-32 (IEEE) of a block of bytes, used to spot torn or corrupt records
+ */
+uint32_t crc32(const char* data, size_t length) {
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        ready = true;
+    }
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// little-endian encoders for the log and checkpoint formats
+void putU32(string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += (char)(value >> (8 * i));
+    }
+}
+
+void putU64(string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out += (char)(value >> (8 * i));
+    }
+}
+
+void putString(string& out, const string& value) {
+    putU32(out, (uint32_t)value.size());
+    out += value;
+}
+
+void putBid(string& out, const Bid& bid) {
+    uint64_t amount;
+    memcpy(&amount, &bid.amount, sizeof(amount));
+    putString(out, bid.bidId);
+    putString(out, bid.title);
+    putString(out, bid.fund);
+    putU64(out, amount);
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement a bounds-checked decoder for the formats above.
+ *
+ * Reading past the end sets Ok() to false instead of throwing.
+ */
+class ByteReader {
+
+private:
+    const string& data;
+    size_t position;
+    bool ok = true;
 
-// define a structure to hold bid information
-struct Bid {
-    string bidId; // unique identifier
-    string title;
-    string fund;
-    double amount;
-    Bid() {
-        amount = 0.0;
+    bool has(size_t bytes) {
+        ok = ok && data.size() - position >= bytes;
+        return ok;
     }
+
+public:
+    ByteReader(const string& aData, size_t start = 0) : data(aData), position(start) {}
+
+    bool Ok() const {
+        return ok;
+    }
+
+    size_t Position() const {
+        return position;
+    }
+
+    void Skip(size_t bytes) {
+        if (has(bytes)) {
+            position += bytes;
+        }
+    }
+
+    unsigned char U8() {
+        return has(1) ? (unsigned char)data[position++] : 0;
+    }
+
+    uint32_t U32() {
+        uint32_t value = 0;
+        if (has(4)) {
+            for (int i = 0; i < 4; ++i) {
+                value |= (uint32_t)(unsigned char)data[position++] << (8 * i);
+            }
+        }
+        return value;
+    }
+
+    uint64_t U64() {
+        uint64_t value = 0;
+        if (has(8)) {
+            for (int i = 0; i < 8; ++i) {
+                value |= (uint64_t)(unsigned char)data[position++] << (8 * i);
+            }
+        }
+        return value;
+    }
+
+    string String() {
+        uint32_t length = U32();
+        if (!has(length)) {
+            return string();
+        }
+        position += length;
+        return data.substr(position - length, length);
+    }
+
+    Bid ReadBid() {
+        Bid bid;
+        bid.bidId = String();
+        bid.title = String();
+        bid.fund = String();
+        uint64_t amount = U64();
+        memcpy(&bid.amount, &amount, sizeof(amount));
+        return bid;
+    }
+};
+
+/**
+ * Flush a stdio file all the way to the disk
+ */
+void syncFile(FILE* file) {
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+/**
+ * Read a whole file into a string
+ *
+ * @return false if the file does not exist or cannot be read
+ */
+bool readFile(const string& path, string& contents) {
+    ifstream file(path.c_str(), ios::binary);
+    if (!file) {
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * Define a class containing data members and methods to
+ * implement an append-only, group-committed log of table mutations.
+ *
+ * Each record is framed as [length][crc32][payload], so recovery can
+ * tell a complete record from one torn by a crash. Appended records wait
+ * in memory and reach the disk together, with one fsync per group of
+ * WAL_GROUP_RECORDS or whenever Commit is called.
+ */
+class WriteAheadLog {
+
+private:
+    string path;
+    FILE* file = nullptr;
+    string pending;
+    unsigned int pendingRecords = 0;
+
+public:
+    WriteAheadLog(const string& aPath) : path(aPath) {}
+    ~WriteAheadLog();
+    bool Open(bool truncate);
+    void Append(const string& payload);
+    void Commit();
+    bool Reset();
 };
 
+/**
+ * Destructor, committing anything still pending
+ */
+WriteAheadLog::~WriteAheadLog() {
+    if (file != nullptr) {
+        Commit();
+        fclose(file);
+    }
+}
+
+/**
+ * Open the log for appending
+ *
+ * @param truncate true to start an empty log
+ * @return false if the file cannot be opened
+ */
+bool WriteAheadLog::Open(bool truncate) {
+    if (file != nullptr) {
+        fclose(file);
+    }
+    file = fopen(path.c_str(), truncate ? "wb" : "ab");
+    return file != nullptr;
+}
+
+/**
+ * Frame a record and queue it for the next group commit
+ *
+ * @param payload The encoded mutation
+ */
+void WriteAheadLog::Append(const string& payload) {
+    putU32(pending, (uint32_t)payload.size());
+    putU32(pending, crc32(payload.data(), payload.size()));
+    pending += payload;
+    if (++pendingRecords >= WAL_GROUP_RECORDS) {
+        Commit();
+    }
+}
+
+/**
+ * Write every queued record and wait for the disk to have them
+ */
+void WriteAheadLog::Commit() {
+    if (file == nullptr || pending.empty()) {
+        return;
+    }
+    fwrite(pending.data(), 1, pending.size(), file);
+    syncFile(file);
+    pending.clear();
+    pendingRecords = 0;
+}
+
+/**
+ * Empty the log once a checkpoint holds everything in it
+ */
+bool WriteAheadLog::Reset() {
+    pending.clear();
+    pendingRecords = 0;
+    return Open(true);
+}
+
 //============================================================================
 // Hash Table class definition
 //============================================================================
 
+/**
+ * Snapshot of how evenly a hash table spreads its keys
+ *
+ * Costs are in nodes visited. The ideal figures are what a uniform hash
+ * would give at the same load factor: 1 + a/2 per hit and a per miss.
+ */
+struct HashTableHealth {
+    unsigned int buckets = 0;
+    unsigned int occupied = 0;          // buckets holding at least one bid
+    size_t entries = 0;
+    size_t maxChain = 0;
+    double loadFactor = 0.0;            // entries / buckets
+    double expectedHitCost = 0.0;       // mean nodes visited to find a stored bid
+    double expectedMissCost = 0.0;      // mean nodes visited for an absent id
+    double idealHitCost = 0.0;
+    double idealOccupied = 0.0;         // buckets a uniform hash would fill
+    vector<size_t> chainHistogram;      // chainHistogram[len] = buckets with len bids
+    bool degenerate = false;
+
+    void Print() const;
+};
+
 /**
  * Define a class containing data members and methods to
  * implement a hash table with chaining.
+ *
+ * Hasher is a policy turning a bid id into an unsigned int; the table
+ * reduces it modulo its size. HashTable keeps the labs' AtoiHasher.
  */
-class HashTable {
+template <typename Hasher>
+class BasicHashTable {
 
 private:
     // Define structures to hold bids
@@ -75,24 +609,75 @@ private:
     Node* tail;
 
     unsigned int tableSize = DEFAULT_SIZE;
+    size_t size = 0;
+
+    // optional filter answering most lookups for absent ids without a probe
+    BloomFilter* bloom = nullptr;
+
+    // secondary indexes, kept in step with the table on Insert/Remove
+    map<string, multiset<string>> fundIndex;  // fund -> posting list of bid ids
+    multimap<double, string> amountIndex;   // amount -> bid id, ordered by amount
+    PrefixTrie titleTrie;                   // lower-cased title -> title
+
+#ifdef BID_STATS
+    ContainerStats stats;
+#endif
+
+    // optional write-ahead log and checkpoint sharing one path prefix
+    WriteAheadLog* wal = nullptr;
+    string dataPrefix;
+    uint64_t lsn = 0;               // sequence number of the last logged mutation
+    uint64_t sinceCheckpoint = 0;   // mutations logged since the last checkpoint
+    uint64_t checkpointSize = 0;    // bids the last checkpoint held
+    string sourceState;             // how far the source CSV has been read
+    bool resuming = false;          // recovered bids may be read from the source again
 
-    unsigned int hash(int key);
+    Hasher hasher;
+
+    unsigned int hash(const string& bidId);
+    void logMutation(unsigned char type, const string& body);
+    void indexBid(Bid bid);
+    void unindexBid(Bid bid);
+    void rebuildBloom(size_t expectedBids);
 
 public:
-    HashTable();
-    HashTable(unsigned int size);
-    virtual ~HashTable();
+    BasicHashTable();
+    BasicHashTable(unsigned int size);
+    virtual ~BasicHashTable();
     void Insert(Bid bid);
     void PrintAll();
+    void Export(ostream& out, ExportFormat format);
     void Remove(string bidId);
     Bid Search(string bidId);
+    vector<Bid> SearchBatch(const vector<string>& bidIds);
+    vector<Bid> SearchByFund(string fund);
+    vector<Bid> SearchByAmount(double low, double high);
+    vector<string> CompleteTitle(string prefix, unsigned int k);
+    HashTableHealth Health(double warnRatio = HEALTH_WARN_RATIO);
+    void EnableBloomFilter(size_t expectedBids);
     size_t Size();
+    size_t EnableDurability(const string& prefix);
+    void Commit();
+    bool Checkpoint();
+    void SetSourceState(const string& state);
+    string SourceState();
+    void ResumeSource();
+    void TakeOverDurability(BasicHashTable& previous);
+#ifdef BID_STATS
+    ContainerStats& Stats() {
+        return stats;
+    }
+#endif
 };
 
+// the hash table the lab programs use
+typedef BasicHashTable<AtoiHasher> HashTable;
+
 /**
  * Default constructor
  */
-HashTable::HashTable() {
+template <typename Hasher>
+BasicHashTable<Hasher>::BasicHashTable() {
     // FIXME (1): Initialize the structures used to hold bids
     // Initalize node structure by resizing tableSize
     head = NULL;   // Assign head to NUll
@@ -106,7 +691,8 @@ HashTable::HashTable() {
  * Use to improve efficiency of hashing algorithm
  * by reducing collisions without wasting memory.
  */
-HashTable::HashTable(unsigned int size) {
+template <typename Hasher>
+BasicHashTable<Hasher>::BasicHashTable(unsigned int size) {
     // invoke local tableSize to size with this->
     this->tableSize = size;
     // resize nodes size
@@ -117,35 +703,37 @@ HashTable::HashTable(unsigned int size) {
 /**
  * Destructor
  */
-HashTable::~HashTable() {
+template <typename Hasher>
+BasicHashTable<Hasher>::~BasicHashTable() {
     // FIXME (2): Implement logic to free storage when class is destroyed
-    // need to start at head
-    Node *current = head;
-    Node* temp;
-    // loop to go over each node and remove from list and delete it
-    while (current != NULL) {
-        temp = current;             // store current node
-        current = current->next;    // assign next node as current node
-        delete temp;                // delete node stored as temp
-        return;
+    // bucket heads live in the vector; only the chained nodes were new'd
+    for (unsigned int i = 0; i < nodes.size(); ++i) {
+        Node* current = nodes[i].next;
+        Node* temp;
+        // loop to go over each node and remove from list and delete it
+        while (current != NULL) {
+            temp = current;             // store current node
+            current = current->next;    // assign next node as current node
+            delete temp;                // delete node stored as temp
+        }
     }
-    // erase nodes beginning
-    nodes.erase(nodes.begin());
+    delete bloom;
+    delete wal;
 }
 
 /**
- * Calculate the hash value of a given key.
- * Note that key is specifically defined as
- * unsigned int to prevent undefined results
- * of a negative list index.
+ * Calculate the bucket for a given bid id.
+ * The hasher's result is unsigned to prevent
+ * undefined results of a negative list index.
  *
- * @param key The key to hash
+ * @param bidId The bid id to hash
  * @return The calculated hash
  */
-unsigned int HashTable::hash(int key) {
+template <typename Hasher>
+unsigned int BasicHashTable<Hasher>::hash(const string& bidId) {
     // FIXME (3): Implement logic to calculate a hash value
     // return key tableSize
-    unsigned int hashVal = key % tableSize;
+    unsigned int hashVal = hasher(bidId) % tableSize;
     return hashVal;
 }
 
@@ -154,10 +742,22 @@ unsigned int HashTable::hash(int key) {
  *
  * @param bid The bid to insert
  */
-void HashTable::Insert(Bid bid) {
+template <typename Hasher>
+void BasicHashTable<Hasher>::Insert(Bid bid) {
+    STATS_TIMER(insert);
+    // recovered from disk already, now being read again from the source
+    if (resuming && !Search(bid.bidId).bidId.empty()) {
+        return;
+    }
+    if (wal != nullptr) {
+        string body;
+        putBid(body, bid);
+        logMutation(WAL_INSERT, body);
+    }
+
     // FIXME (4): Implement logic to insert a bid
     // create the key for the given bid
-    unsigned key = hash(atoi(bid.bidId.c_str()));
+    unsigned key = hash(bid.bidId);
     // retrieve node using key
     // if no entry found for the key
         // assign this node to the key position
@@ -172,41 +772,63 @@ void HashTable::Insert(Bid bid) {
     else {
         Node *currNode = &nodes.at(key);
         Node* newNode = new Node(bid, key);
+        STATS_COUNT(allocations);
         while (currNode->next != NULL) {
             currNode = currNode->next;
+            STATS_COUNT(insert.visited);
         }
         currNode->next = newNode;
         nodes.resize(tableSize);
     }
 
+    // keep the fund and amount indexes in step with the table
+    indexBid(bid);
+
+    // grow the filter once the table outgrows what it was sized for
+    size++;
+    if (bloom != nullptr) {
+        if (size > bloom->Capacity()) {
+            rebuildBloom(size * 2);
+        }
+        else {
+            bloom->Add(bid.bidId);
+        }
+    }
 }
 
 /**
  * Print all bids
  */
-void HashTable::PrintAll() {
+template <typename Hasher>
+void BasicHashTable<Hasher>::PrintAll() {
     // FIXME (5): Implement logic to print all bids
+    Export(cout, EXPORT_TEXT);
+}
+
+/**
+ * Write every bid, bucket by bucket, in one of the export formats
+ *
+ * @param out Where to write the bids
+ * @param format Text, CSV or JSON Lines
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::Export(ostream& out, ExportFormat format) {
+    STATS_TIMER(traverse);
     // for node begin to end iterate
     //   if key not equal to UINT_MAx
-            // output key, bidID, title, amount and fund
-            // node is equal to next iter
-            // while node not equal to nullptr
-               // output key, bidID, title, amount and fund
-               // node is equal to next node
+            // collect the bid, then every bid chained behind it
+    vector<const Bid*> bids;
+    bids.reserve(size);
     for (unsigned int i = 0; i < tableSize; i++) {
-        Node* node = &nodes.at(i);
-        if (node->key != UINT_MAX); {
-            cout << "Key:" << i << " "
-                << node->bid.bidId << "|" << node->bid.title << "|" << node->bid.amount
-                << " | " << node->bid.fund << endl;
-            while (node->next != nullptr) {
-                node = node->next;
-                cout << node->key << ": " << node->bid.bidId << " | " << node->bid.title << " | " << node->bid.amount << " | " << node->bid.fund << endl;
-            }
+        if (nodes[i].key == UINT_MAX) {
+            continue;
+        }
+        for (Node* node = &nodes[i]; node != nullptr; node = node->next) {
+            STATS_COUNT(traverse.visited);
+            bids.push_back(&node->bid);
         }
     }
-    return;
-
+    exportBids(bids, out, format);
 }
 
 /**
@@ -214,13 +836,64 @@ void HashTable::PrintAll() {
  *
  * @param bidId The bid id to search for
  */
-void HashTable::Remove(string bidId) {
+template <typename Hasher>
+void BasicHashTable<Hasher>::Remove(string bidId) {
+    STATS_TIMER(remove);
     // FIXME (6): Implement logic to remove a bid
+    if (bloom != nullptr && !bloom->MayContain(bidId)) {
+        STATS_COUNT(remove.misses);
+        return;
+    }
+    if (wal != nullptr) {
+        string body;
+        putString(body, bidId);
+        logMutation(WAL_REMOVE, body);
+    }
+
     // set key equal to hash atoi bidID cstring
-    // erase node begin and key
-    unsigned key = hash(atoi(bidId.c_str()));
-    nodes.erase(nodes.begin() + key);
-    nodes.resize(tableSize);
+    unsigned key = hash(bidId);
+    Node* node = &nodes.at(key);
+
+    // nothing stored in this bucket
+    if (node->key == UINT_MAX) {
+        STATS_COUNT(remove.misses);
+        return;
+    }
+
+    // match on the bucket itself: pull the next chained node up into the slot
+    STATS_COUNT(remove.visited);
+    if (node->bid.bidId.compare(bidId) == 0) {
+        STATS_COUNT(remove.hits);
+        unindexBid(node->bid);
+        size--;
+        if (node->next == nullptr) {
+            *node = Node();           // bucket is empty again
+        }
+        else {
+            Node* temp = node->next;  // hang on to the chained node
+            *node = *temp;            // copy it into the bucket
+            delete temp;              // free the orphan
+        }
+        return;
+    }
+
+    // otherwise walk the chain looking for a match
+    Node* prev = node;
+    node = node->next;
+    while (node != nullptr) {
+        STATS_COUNT(remove.visited);
+        if (node->bid.bidId.compare(bidId) == 0) {
+            STATS_COUNT(remove.hits);
+            unindexBid(node->bid);
+            size--;
+            prev->next = node->next;  // unlink the match
+            delete node;
+            return;
+        }
+        prev = node;
+        node = node->next;
+    }
+    STATS_COUNT(remove.misses);
 }
 
 /**
@@ -228,102 +901,623 @@ void HashTable::Remove(string bidId) {
  *
  * @param bidId The bid id to search for
  */
-Bid HashTable::Search(string bidId) {
+template <typename Hasher>
+Bid BasicHashTable<Hasher>::Search(string bidId) {
+    STATS_TIMER(search);
     Bid bid;
 
     // FIXME (7): Implement logic to search for and return a bid
+    if (bloom != nullptr && !bloom->MayContain(bidId)) {
+        STATS_COUNT(search.misses);
+        return bid;
+    }
 
     // create the key for the given bid
     // if entry found for the key
          //return node bid
-    unsigned key = hash(atoi(bidId.c_str()));
+    unsigned key = hash(bidId);
     Node* node = &(nodes.at(key));
         
 
     // if no entry found for the key
       // return bid
     if (node == nullptr || node->key == UINT_MAX) {
+        STATS_COUNT(search.misses);
         return bid;
      }
     // while node not equal to nullptr
         // if the current node matches, return it
         //node is equal to next node
     while (node != nullptr) {
+        STATS_COUNT(search.visited);
         if (node->key != UINT_MAX && node->bid.bidId.compare(bidId) == 0) {
+            STATS_COUNT(search.hits);
             return node->bid;
         }
         node = node->next;
     }
 
+    STATS_COUNT(search.misses);
     return bid;
 }
 
-//============================================================================
-// Static methods used for testing
-//============================================================================
+/**
+ * Search for many bid ids at once
+ *
+ * Every id is hashed first so the bucket addresses are known up front.
+ * While key i is resolved, the bucket for key i + BATCH_PREFETCH_DISTANCE
+ * is requested, and the first chained node of the bucket requested half
+ * that distance ago, so the cache misses of later lookups overlap the
+ * work on earlier ones.
+ *
+ * @param bidIds The bid ids to search for
+ * @return one bid per id, in the same order; empty where not found
+ */
+template <typename Hasher>
+vector<Bid> BasicHashTable<Hasher>::SearchBatch(const vector<string>& bidIds) {
+    size_t count = bidIds.size();
+    vector<Bid> bids(count);
+    vector<unsigned int> keys(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = hash(bidIds[i]);
+    }
+
+    // prime the pipeline; a bucket spans two cache lines, the id at the
+    // front and the key and chain pointer at the back
+    size_t distance = BATCH_PREFETCH_DISTANCE;
+    for (size_t i = 0; i < count && i < distance; ++i) {
+        PREFETCH(&nodes[keys[i]]);
+        PREFETCH(&nodes[keys[i]].next);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (i + distance < count) {
+            PREFETCH(&nodes[keys[i + distance]]);
+            PREFETCH(&nodes[keys[i + distance]].next);
+        }
+        if (i + distance / 2 < count) {
+            Node* chained = nodes[keys[i + distance / 2]].next;
+            if (chained != nullptr) {
+                PREFETCH(chained);
+            }
+        }
+
+        Node* node = &nodes[keys[i]];
+        if (node->key == UINT_MAX) {
+            continue;
+        }
+        while (node != nullptr) {
+            if (node->bid.bidId == bidIds[i]) {
+                bids[i] = node->bid;
+                break;
+            }
+            node = node->next;
+        }
+    }
+    return bids;
+}
+
+/**
+ * Search for all bids posted against a fund
+ *
+ * @param fund The fund to look up
+ * @return the matching bids, in bid id order
+ */
+template <typename Hasher>
+vector<Bid> BasicHashTable<Hasher>::SearchByFund(string fund) {
+    vector<Bid> bids;
+
+    // look up the posting list and resolve each id through the table
+    map<string, multiset<string>>::iterator it = fundIndex.find(fund);
+    if (it == fundIndex.end()) {
+        return bids;
+    }
+    for (const string& bidId : it->second) {
+        bids.push_back(Search(bidId));
+    }
+    return bids;
+}
+
+/**
+ * Search for all bids whose amount falls within a range
+ *
+ * @param low The lowest amount to include
+ * @param high The highest amount to include
+ * @return the matching bids, ordered by amount
+ */
+template <typename Hasher>
+vector<Bid> BasicHashTable<Hasher>::SearchByAmount(double low, double high) {
+    vector<Bid> bids;
+
+    // walk only the slice of the amount index inside [low, high]
+    multimap<double, string>::iterator it = amountIndex.lower_bound(low);
+    multimap<double, string>::iterator end = amountIndex.upper_bound(high);
+    for (; it != end; ++it) {
+        bids.push_back(Search(it->second));
+    }
+    return bids;
+}
+
+/**
+ * Suggest titles that start with what has been typed so far
+ *
+ * @param prefix The start of a title, case-insensitive
+ * @param k The most suggestions to return
+ * @return up to k distinct titles, in alphabetical order
+ */
+template <typename Hasher>
+vector<string> BasicHashTable<Hasher>::CompleteTitle(string prefix, unsigned int k) {
+    return titleTrie.Complete(foldCase(prefix), k);
+}
+
+/**
+ * Add a bid to the fund and amount indexes
+ *
+ * @param bid The bid that was just inserted
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::indexBid(Bid bid) {
+    fundIndex[bid.fund].insert(bid.bidId);
+    amountIndex.insert(make_pair(bid.amount, bid.bidId));
+    titleTrie.Insert(foldCase(bid.title), bid.title);
+}
+
+/**
+ * Drop a bid from the fund and amount indexes
+ *
+ * @param bid The bid that is being removed
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::unindexBid(Bid bid) {
+    titleTrie.Remove(foldCase(bid.title));
+
+    // remove one posting for this id from its fund
+    map<string, multiset<string>>::iterator fund = fundIndex.find(bid.fund);
+    if (fund != fundIndex.end()) {
+        multiset<string>& postings = fund->second;
+        multiset<string>::iterator pos = postings.find(bid.bidId);
+        if (pos != postings.end()) {
+            postings.erase(pos);
+        }
+        if (postings.empty()) {
+            fundIndex.erase(fund);
+        }
+    }
+
+    // remove one entry for this id at its amount
+    pair<multimap<double, string>::iterator, multimap<double, string>::iterator> range =
+        amountIndex.equal_range(bid.amount);
+    for (multimap<double, string>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == bid.bidId) {
+            amountIndex.erase(it);
+            break;
+        }
+    }
+}
 
 /**
- * Display the bid information to the console (std::out)
+ * Put a Bloom filter in front of Search and Remove
  *
- * @param bid struct containing the bid info
+ * Lookups for ids the filter has never seen return without touching the
+ * table. The filter is sized for the bids already stored plus
+ * expectedBids, and is rebuilt at twice the size if the table outgrows it.
+ *
+ * @param expectedBids How many more bids are expected
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::EnableBloomFilter(size_t expectedBids) {
+    rebuildBloom(size + expectedBids);
+}
+
+/**
+ * Replace the Bloom filter with one sized for expectedBids, holding
+ * every stored bid
  */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-            << bid.fund << endl;
-    return;
+template <typename Hasher>
+void BasicHashTable<Hasher>::rebuildBloom(size_t expectedBids) {
+    delete bloom;
+    bloom = new BloomFilter(expectedBids);
+    for (unsigned int i = 0; i < tableSize; ++i) {
+        if (nodes[i].key == UINT_MAX) {
+            continue;
+        }
+        for (Node* node = &nodes[i]; node != nullptr; node = node->next) {
+            bloom->Add(node->bid.bidId);
+        }
+    }
 }
 
 /**
- * Load a CSV file containing bids into a container
+ * Return the number of bids stored
+ */
+template <typename Hasher>
+size_t BasicHashTable<Hasher>::Size() {
+    return size;
+}
+
+/**
+ * Log every mutation to <prefix>.wal and checkpoint the table to
+ * <prefix>.ckpt, first recovering whatever those files already hold
  *
- * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
+ * Recovery loads the checkpoint, then replays the log records newer than
+ * it, stopping at the first record that is torn or fails its checksum.
+ *
+ * @param prefix Path prefix for the log and checkpoint files
+ * @return the number of log records replayed
  */
-void loadBids(string csvPath, HashTable* hashTable) {
-    cout << "Loading CSV file " << csvPath << endl;
+template <typename Hasher>
+size_t BasicHashTable<Hasher>::EnableDurability(const string& prefix) {
+    dataPrefix = prefix;
 
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
+    // checkpoint: [magic][crc32][lsn][source state][count][bids...]
+    uint64_t checkpointLsn = 0;
+    string contents;
+    if (readFile(prefix + ".ckpt", contents) && contents.size() >= 12
+        && contents.compare(0, 8, CHECKPOINT_MAGIC, 8) == 0) {
+        ByteReader header(contents, 8);
+        uint32_t crc = header.U32();
+        if (crc == crc32(contents.data() + 12, contents.size() - 12)) {
+            ByteReader reader(contents, 12);
+            checkpointLsn = reader.U64();
+            sourceState = reader.String();
+            uint64_t count = reader.U64();
+            for (uint64_t i = 0; i < count && reader.Ok(); ++i) {
+                Insert(reader.ReadBid());
+            }
+        } else {
+            cout << "ignoring corrupt checkpoint " << prefix << ".ckpt" << endl;
+        }
+    }
+    lsn = checkpointLsn;
 
-    // read and display header row - optional
-    vector<string> header = file.getHeader();
-    for (auto const& c : header) {
-        cout << c << " | ";
+    // log: [length][crc32][op][lsn][body], replayed past the checkpoint
+    size_t replayed = 0;
+    bool torn = false;
+    if (readFile(prefix + ".wal", contents)) {
+        ByteReader reader(contents);
+        while (reader.Position() < contents.size()) {
+            uint32_t length = reader.U32();
+            uint32_t crc = reader.U32();
+            if (!reader.Ok() || contents.size() - reader.Position() < length
+                || crc32(contents.data() + reader.Position(), length) != crc) {
+                torn = true;
+                break;
+            }
+            ByteReader record(contents, reader.Position());
+            reader.Skip(length);
+
+            unsigned char type = record.U8();
+            uint64_t recordLsn = record.U64();
+            if (recordLsn <= checkpointLsn) {
+                continue;
+            }
+            if (type == WAL_INSERT) {
+                Insert(record.ReadBid());
+            } else if (type == WAL_REMOVE) {
+                Remove(record.String());
+            } else if (type == WAL_SOURCE) {
+                sourceState = record.String();
+            }
+            lsn = recordLsn;
+            ++replayed;
+        }
     }
-    cout << "" << endl;
 
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
+    // log from here on; a torn tail is folded into a fresh checkpoint so
+    // nothing is ever appended after bytes recovery would stop at
+    wal = new WriteAheadLog(prefix + ".wal");
+    if (torn) {
+        cout << "dropped a torn record at the end of " << prefix << ".wal" << endl;
+        Checkpoint();
+    } else if (!wal->Open(false)) {
+        cout << "could not open " << prefix << ".wal for writing" << endl;
+    }
+    return replayed;
+}
 
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
+/**
+ * Force every logged mutation to the disk
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::Commit() {
+    if (wal != nullptr) {
+        wal->Commit();
+    }
+}
 
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
+/**
+ * Write the whole table to <prefix>.ckpt and empty the log
+ *
+ * The checkpoint is written to a temporary file, synced and renamed
+ * over the old one, so a crash leaves either checkpoint intact.
+ *
+ * @return false if durability is off or the checkpoint was not written
+ */
+template <typename Hasher>
+bool BasicHashTable<Hasher>::Checkpoint() {
+    if (wal == nullptr) {
+        return false;
+    }
 
-            // push this bid to the end
-            hashTable->Insert(bid);
+    string body;
+    putU64(body, lsn);
+    putString(body, sourceState);
+    putU64(body, size);
+    for (unsigned int i = 0; i < tableSize; ++i) {
+        if (nodes[i].key == UINT_MAX) {
+            continue;
+        }
+        for (Node* node = &nodes[i]; node != nullptr; node = node->next) {
+            putBid(body, node->bid);
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
     }
+    string data(CHECKPOINT_MAGIC, 8);
+    putU32(data, crc32(body.data(), body.size()));
+    data += body;
+
+    string path = dataPrefix + ".ckpt";
+    string temp = path + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    syncFile(file);
+    fclose(file);
+    if (!written) {
+        return false;
+    }
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows
+    remove(path.c_str());
+#endif
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+
+    sinceCheckpoint = 0;
+    checkpointSize = size;
+    return wal->Reset();
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Record how far the source CSV has been read, so a restart can resume
+ * following it instead of loading it again
  *
- * credit: http://stackoverflow.com/a/24875936
+ * @param state Opaque position from BidFileFollower::State
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::SetSourceState(const string& state) {
+    if (state == sourceState) {
+        return;
+    }
+    sourceState = state;
+    resuming = false;
+    if (wal != nullptr) {
+        string body;
+        putString(body, state);
+        logMutation(WAL_SOURCE, body);
+    }
+}
+
+/**
+ * Return the source position recovered or last recorded
+ */
+template <typename Hasher>
+string BasicHashTable<Hasher>::SourceState() {
+    return sourceState;
+}
+
+/**
+ * Get ready for the source to be followed again from SourceState
  *
- * @param ch The character to strip out
+ * Rows past the last recorded source position were stored but will be
+ * read again, so Insert skips ids it holds until the position moves on.
+ * Only a caller that re-reads the source should ask for this.
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+template <typename Hasher>
+void BasicHashTable<Hasher>::ResumeSource() {
+    resuming = size > 0;
+}
+
+/**
+ * Move the log and checkpoint over from the table this one replaces,
+ * then checkpoint so the files describe this table instead
+ *
+ * @param previous The version being replaced; it stops logging
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::TakeOverDurability(BasicHashTable& previous) {
+    if (previous.wal == nullptr) {
+        return;
+    }
+    previous.wal->Commit();
+    wal = previous.wal;
+    previous.wal = nullptr;
+    dataPrefix = previous.dataPrefix;
+    lsn = previous.lsn;
+    Checkpoint();
+}
+
+/**
+ * Append one mutation to the log, checkpointing first once
+ * CHECKPOINT_INTERVAL records, or as many as the last checkpoint held
+ * bids, have built up, so replay stays short without bulk loads stalling
+ * on ever larger checkpoints
+ *
+ * @param type WAL_INSERT, WAL_REMOVE or WAL_SOURCE
+ * @param body The encoded arguments
+ */
+template <typename Hasher>
+void BasicHashTable<Hasher>::logMutation(unsigned char type, const string& body) {
+    if (sinceCheckpoint >= max(CHECKPOINT_INTERVAL, checkpointSize)) {
+        Checkpoint();
+    }
+    string payload(1, (char)type);
+    putU64(payload, ++lsn);
+    payload += body;
+    wal->Append(payload);
+    ++sinceCheckpoint;
+}
+
+/**
+ * Measure the bucket occupancy and chain length distribution
+ *
+ * The table is flagged degenerate when a hit costs more than warnRatio
+ * times the uniform-hashing figure, or when fewer than 1/warnRatio of
+ * the buckets a uniform hash would fill are in use.
+ *
+ * @param warnRatio How much worse than uniform hashing to tolerate
+ * @return the health snapshot
+ */
+template <typename Hasher>
+HashTableHealth BasicHashTable<Hasher>::Health(double warnRatio) {
+    HashTableHealth health;
+    health.buckets = tableSize;
+
+    // a hit on the i-th node of a chain visits i nodes, so a chain of
+    // length L contributes L(L+1)/2 to the total hit cost
+    double hitCost = 0.0;
+    for (unsigned int i = 0; i < tableSize; ++i) {
+        size_t length = 0;
+        if (nodes[i].key != UINT_MAX) {
+            for (Node* node = &nodes[i]; node != nullptr; node = node->next) {
+                ++length;
+            }
+        }
+        if (length >= health.chainHistogram.size()) {
+            health.chainHistogram.resize(length + 1, 0);
+        }
+        health.chainHistogram[length]++;
+        if (length > 0) {
+            health.occupied++;
+        }
+        health.entries += length;
+        health.maxChain = max(health.maxChain, length);
+        hitCost += length * (length + 1) / 2.0;
+    }
+
+    if (tableSize == 0) {
+        return health;
+    }
+    health.loadFactor = double(health.entries) / tableSize;
+    health.expectedMissCost = health.loadFactor;
+    health.idealHitCost = 1.0 + health.loadFactor / 2.0;
+    health.idealOccupied = tableSize * (1.0 - exp(-health.loadFactor));
+    if (health.entries > 0) {
+        health.expectedHitCost = hitCost / health.entries;
+        health.degenerate = health.expectedHitCost > warnRatio * health.idealHitCost
+            || health.occupied * warnRatio < health.idealOccupied;
+    }
+    return health;
+}
+
+/**
+ * Print a health snapshot and its chain length histogram
+ */
+void HashTableHealth::Print() const {
+    cout << "buckets: " << buckets << ", occupied: " << occupied
+        << " (uniform hashing would fill " << idealOccupied << ")" << endl;
+    cout << "entries: " << entries << ", load factor: " << loadFactor
+        << ", max chain: " << maxChain << endl;
+    cout << "expected cost per hit: " << expectedHitCost
+        << " nodes (ideal " << idealHitCost << "), per miss: " << expectedMissCost << " nodes" << endl;
+    cout << "chain length  buckets" << endl;
+    for (size_t length = 0; length < chainHistogram.size(); ++length) {
+        if (chainHistogram[length] > 0) {
+            cout << "  " << length << "  " << chainHistogram[length] << endl;
+        }
+    }
+    if (degenerate) {
+        cout << "WARNING: keys are not spreading evenly over the buckets" << endl;
+    }
+}
+
+//============================================================================
+// Static methods used for testing
+//============================================================================
+
+/**
+ * Lower-case a string so lookups ignore case
+ *
+ * @param str The string to fold
+ * @return the folded copy
+ */
+string foldCase(string str) {
+    for (auto& c : str) {
+        c = (char)tolower((unsigned char)c);
+    }
+    return str;
+}
+
+/**
+ * Create the empty table each load of the bid file starts from
+ */
+HashTable* newBidTable() {
+    HashTable* table = new HashTable();
+    table->EnableBloomFilter(EXPECTED_BIDS);
+    return table;
+}
+
+/**
+ * Bring the published table up to date with the bid file
+ *
+ * A table published by a finished background load takes the write-ahead
+ * log over from the version it replaces. Either way the table records
+ * how far the file has been read, once any of it has been.
+ *
+ * @return the number of bids read, or -1 if the file cannot be read
+ */
+long refreshTable(SnapshotStore<HashTable>& tables, BidFileFollower& follower,
+    BackgroundLoader<HashTable>& loader) {
+    shared_ptr<HashTable> previous = tables.Pin();
+    long loaded = followSnapshot(tables, follower, loader, newBidTable);
+    shared_ptr<HashTable> current = tables.Pin();
+    if (current != previous) {
+        current->TakeOverDurability(*previous);
+
+        // surface a badly spread table as soon as it is loaded
+        if (current->Health().degenerate) {
+            cout << "WARNING: hash distribution is degenerate, see Table Health" << endl;
+        }
+    }
+    // while a background load runs, or after one was cancelled, the
+    // follower has not read anything yet and there is no position to keep
+    if (loaded >= 0 && follower.Offset() > 0) {
+        current->SetSourceState(follower.State());
+    }
+    return loaded;
+}
+
+/**
+ * Run the benchmark sweep over the hash table, once at its default
+ * size and once sized to the data
+ */
+void runBenchmarks(const BenchmarkOptions& options) {
+    printBenchmarkHeader(options);
+
+    // at the default 179 buckets every insert walks a long chain, so the
+    // sweep stops at 100k where a load still takes seconds, not hours
+    BenchmarkOptions fixedSize = options;
+    fixedSize.maxBids = min(options.maxBids, 100000u);
+    benchmarkIndex<HashTable>("HashTable(179)", fixedSize, false);
+
+    benchmarkIndex<HashTable>("HashTable(179)+bloom", fixedSize, false,
+        [](unsigned int bids) {
+            HashTable* table = new HashTable();
+            table->EnableBloomFilter(bids);
+            return table;
+        });
+
+    benchmarkIndex<HashTable>("HashTable(n)", options, false,
+        [](unsigned int bids) { return new HashTable(bids); });
+
+    benchmarkIndex<BasicHashTable<FnvHasher>>("HashTable(n,fnv)", options, false,
+        [](unsigned int bids) { return new BasicHashTable<FnvHasher>(bids); });
+
+    // per-key ns for batched lookups against the one-at-a-time loop
+    benchmarkBatchSearch<HashTable>("HashTable(n)", options,
+        [](unsigned int bids) { return new HashTable(bids); });
 }
 
 /**
@@ -331,6 +1525,31 @@ double strToDouble(string str, char ch) {
  */
 int main(int argc, char* argv[]) {
 
+    // --data <prefix> keeps the table in <prefix>.wal and <prefix>.ckpt
+    string dataPrefix;
+    if (argc >= 3 && string(argv[1]) == "--data") {
+        dataPrefix = argv[2];
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    // non-interactive benchmark sweep
+    if (argc >= 2 && string(argv[1]) == "--benchmark") {
+        runBenchmarks(parseBenchmarkOptions(argc, argv));
+        return 0;
+    }
+
+    // non-interactive batch of operations: --batch [operations] [results]
+    if (argc >= 2 && string(argv[1]) == "--batch") {
+        HashTable table;
+        table.EnableBloomFilter(EXPECTED_BIDS);
+        if (!dataPrefix.empty()) {
+            table.EnableDurability(dataPrefix);
+        }
+        return runBatchCommand(argc, argv, &table);
+    }
+
     // process command line arguments
     string csvPath, bidKey;
     switch (argc) {
@@ -350,38 +1569,85 @@ int main(int argc, char* argv[]) {
     // Define a timer variable
     clock_t ticks;
 
-    // Define a hash table to hold all the bids
-    HashTable* bidTable;
+    // Define a hash table to hold all the bids; each reload publishes a
+    // new version and every command pins the one it works on
+    SnapshotStore<HashTable> tables(newBidTable());
 
     Bid bid;
-    bidTable = new HashTable();
-    
+
+    // Load Bids reads the file once, then follows rows appended to it
+    BidFileFollower follower(csvPath);
+    BackgroundLoader<HashTable> loader;
+    bool following = false;
+
+    // recover the table, and how far the file had been read, from disk
+    if (!dataPrefix.empty()) {
+        shared_ptr<HashTable> recovered = tables.Pin();
+        size_t replayed = recovered->EnableDurability(dataPrefix);
+        cout << "recovered " << recovered->Size() << " bids from " << dataPrefix
+            << " (" << replayed << " log records replayed)" << endl;
+        following = follower.Restore(recovered->SourceState());
+        if (following) {
+            recovered->ResumeSource();
+        }
+    }
+
     int choice = 0;
     while (choice != 9) {
         cout << "Menu:" << endl;
-        cout << "  1. Load Bids" << endl;
+        cout << "  1. Load Bids";
+        if (loader.Running()) {
+            cout << " (" << loader.Percent() << "% loaded)";
+        }
+        cout << endl;
         cout << "  2. Display All Bids" << endl;
         cout << "  3. Find Bid" << endl;
         cout << "  4. Remove Bid" << endl;
+        cout << "  5. Find Bids by Fund" << endl;
+        cout << "  6. Find Bids by Amount" << endl;
+        cout << "  7. Autocomplete Title" << endl;
+#ifdef BID_STATS
+        cout << "  8. Show Statistics" << endl;
+#endif
         cout << "  9. Exit" << endl;
+        cout << " 10. Table Health" << endl;
+        cout << " 11. Checkpoint" << endl;
         cout << "Enter choice: ";
         cin >> choice;
 
+        // publish a finished load, or pick up rows appended while waiting
+        if (following && choice != 1) {
+            refreshTable(tables, follower, loader);
+        }
+        shared_ptr<HashTable> bidTable = tables.Pin();
+
         switch (choice) {
 
-        case 1:
-            
-            // Initialize a timer variable before loading bids
-            ticks = clock();
+        case 1: {
 
-            // Complete the method call to load the bids
-            loadBids(csvPath, bidTable);
+            // a load still running reports its progress and may be cancelled
+            if (loader.Running() && !loader.Finished()) {
+                loader.PrintProgress(cout);
+                cout << "Cancel the load? (y/n) ";
+                string answer;
+                cin >> answer;
+                if (answer == "y" || answer == "Y") {
+                    loader.Cancel();
+                }
+                break;
+            }
 
-            // Calculate elapsed time and display result
-            ticks = clock() - ticks; // current clock ticks minus starting clock ticks
-            cout << "time: " << ticks << " clock ticks" << endl;
-            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            // the first load reads the whole file in the background while
+            // the menu keeps serving the current table, later ones only
+            // appended rows
+            long loaded = refreshTable(tables, follower, loader);
+            if (loaded < 0) {
+                cout << "could not read " << csvPath << endl;
+                break;
+            }
+            following = true;
             break;
+        }
 
         case 2:
             bidTable->PrintAll();
@@ -405,9 +1671,95 @@ int main(int argc, char* argv[]) {
             break;
 
         case 4:
+            // the table being loaded would not see the removal
+            if (loader.Running()) {
+                cout << "a load is in progress, remove the bid once it finishes" << endl;
+                break;
+            }
             bidTable->Remove(bidKey);
             break;
+
+        case 5: {
+            string fund;
+            cout << "Enter fund: ";
+            cin.ignore();
+            getline(cin, fund);
+
+            ticks = clock();
+            vector<Bid> matches = bidTable->SearchByFund(fund);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
+        }
+
+        case 6: {
+            double low, high;
+            cout << "Enter lowest amount: ";
+            cin >> low;
+            cout << "Enter highest amount: ";
+            cin >> high;
+
+            ticks = clock();
+            vector<Bid> matches = bidTable->SearchByAmount(low, high);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
+        }
+
+        case 7: {
+            string prefix;
+            cout << "Enter start of title: ";
+            cin.ignore();
+            getline(cin, prefix);
+
+            ticks = clock();
+            vector<string> titles = bidTable->CompleteTitle(prefix, 10);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < titles.size(); ++i) {
+                cout << "  " << titles[i] << endl;
+            }
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+            break;
         }
+
+        case 10:
+            bidTable->Health().Print();
+            break;
+
+        case 11:
+            if (dataPrefix.empty()) {
+                cout << "start with --data <prefix> to keep the table on disk" << endl;
+            } else if (bidTable->Checkpoint()) {
+                cout << "checkpoint written to " << dataPrefix << ".ckpt" << endl;
+            } else {
+                cout << "could not write " << dataPrefix << ".ckpt" << endl;
+            }
+            break;
+
+#ifdef BID_STATS
+        case 8: {
+            bidTable->Stats().Print("HashTable");
+            ofstream json("HashTable_stats.json");
+            bidTable->Stats().WriteJson(json, "HashTable");
+            cout << "statistics written to HashTable_stats.json" << endl;
+            break;
+        }
+#endif
+        }
+
+        // group commit at command boundaries: a finished command survives a crash
+        bidTable->Commit();
     }
 
     cout << "Good bye." << endl;
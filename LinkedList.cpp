@@ -7,31 +7,266 @@
 //============================================================================
 
 #include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <time.h>
+#include <unordered_map>
+#include <vector>
 
-#include "CSVparser.hpp"
+#include "BidIndex.hpp"
 
 using namespace std;
 
+// removed docs the title index tolerates before it may be compacted; past
+// this it is rebuilt once removed docs outnumber the live ones
+const unsigned int COMPACT_MIN_REMOVED = 1024;
+
 //============================================================================
-// Global definitions visible to all methods and classes
+// Title Index class definition
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
+/**
+ * Define a class containing data members and methods to
+ * implement a trigram inverted index over bid titles.
+ *
+ * Every three-character window of a lower-cased title maps to the
+ * ascending list of document ids that contain it. Lists are stored
+ * delta + varint encoded with a skip entry every SKIP_INTERVAL postings,
+ * so a query intersects its trigram lists without decoding all of them.
+ */
+class TitleIndex {
 
-// define a structure to hold bid information
-struct Bid {
-    string bidId; // unique identifier
-    string title;
-    string fund;
-    double amount;
-    Bid() {
-        amount = 0.0;
-    }
+private:
+    static const unsigned int SKIP_INTERVAL = 64;
+
+    // jump target into the middle of a posting list
+    struct Skip {
+        unsigned int firstDoc;   // first doc id of the block
+        unsigned int baseDoc;    // doc id the block's first delta is relative to
+        unsigned int offset;     // byte offset of the block's first posting
+    };
+
+    // compressed, append-only list of ascending doc ids
+    struct PostingList {
+        vector<unsigned char> bytes;
+        vector<Skip> skips;
+        unsigned int lastDoc = 0;
+        unsigned int count = 0;
+    };
+
+    // sequential reader over one posting list
+    struct Cursor {
+        const PostingList* list;
+        unsigned int offset = 0;
+        unsigned int index = 0;
+        unsigned int doc = 0;
+        bool done = false;
+
+        Cursor(const PostingList* aList) : list(aList) {}
+        void Next();
+        void SeekTo(unsigned int target);
+    };
+
+    unordered_map<unsigned int, PostingList> postings;
+
+    static unsigned int trigramKey(const string& text, size_t pos);
+    static void addPosting(PostingList& list, unsigned int docId);
+
+public:
+    static string Normalize(string text);
+    void Add(unsigned int docId, string title);
+    vector<unsigned int> Candidates(string text);
 };
 
+/**
+ * Lower-case a title or query so matching is case-insensitive
+ *
+ * @param text The text to fold
+ * @return the folded copy
+ */
+string TitleIndex::Normalize(string text) {
+    for (auto& c : text) {
+        c = (char)tolower((unsigned char)c);
+    }
+    return text;
+}
+
+/**
+ * Pack the three characters starting at pos into a single key
+ */
+unsigned int TitleIndex::trigramKey(const string& text, size_t pos) {
+    return ((unsigned int)(unsigned char)text[pos] << 16)
+        | ((unsigned int)(unsigned char)text[pos + 1] << 8)
+        | (unsigned int)(unsigned char)text[pos + 2];
+}
+
+/**
+ * Append a doc id to a posting list as a varint-encoded delta
+ *
+ * @param list The list to append to
+ * @param docId The doc id, never smaller than the last one added
+ */
+void TitleIndex::addPosting(PostingList& list, unsigned int docId) {
+    // a title repeating a trigram only needs to be posted once
+    if (list.count > 0 && docId == list.lastDoc) {
+        return;
+    }
+
+    // start a new block every SKIP_INTERVAL postings
+    if (list.count % SKIP_INTERVAL == 0) {
+        Skip skip;
+        skip.firstDoc = docId;
+        skip.baseDoc = list.lastDoc;
+        skip.offset = (unsigned int)list.bytes.size();
+        list.skips.push_back(skip);
+    }
+
+    // seven bits per byte, high bit set while more bytes follow
+    unsigned int delta = docId - list.lastDoc;
+    while (delta >= 0x80) {
+        list.bytes.push_back((unsigned char)(delta | 0x80));
+        delta >>= 7;
+    }
+    list.bytes.push_back((unsigned char)delta);
+
+    list.lastDoc = docId;
+    list.count++;
+}
+
+/**
+ * Advance the cursor to the next posting
+ */
+void TitleIndex::Cursor::Next() {
+    if (index >= list->count) {
+        done = true;
+        return;
+    }
+
+    // decode one varint delta
+    unsigned int delta = 0;
+    unsigned int shift = 0;
+    unsigned char byte;
+    do {
+        byte = list->bytes[offset++];
+        delta |= (unsigned int)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    doc += delta;
+    index++;
+}
+
+/**
+ * Advance the cursor to the first posting at or after target
+ *
+ * @param target The doc id to seek to
+ */
+void TitleIndex::Cursor::SeekTo(unsigned int target) {
+    if (done || doc >= target) {
+        return;
+    }
+
+    // jump to the last block starting at or before target, if it is ahead of us
+    unsigned int block = index / SKIP_INTERVAL;
+    unsigned int next = block + 1;
+    while (next < list->skips.size() && list->skips[next].firstDoc <= target) {
+        next++;
+    }
+    if (next - 1 > block) {
+        const Skip& skip = list->skips[next - 1];
+        offset = skip.offset;
+        index = (next - 1) * SKIP_INTERVAL;
+        doc = skip.baseDoc;
+        Next();
+    }
+
+    // finish with a short linear scan inside the block
+    while (!done && doc < target) {
+        Next();
+    }
+}
+
+/**
+ * Index every trigram of a title under a doc id
+ *
+ * @param docId The id of the document, ascending across calls
+ * @param title The title text to index
+ */
+void TitleIndex::Add(unsigned int docId, string title) {
+    title = Normalize(title);
+    for (size_t i = 0; i + 3 <= title.size(); ++i) {
+        addPosting(postings[trigramKey(title, i)], docId);
+    }
+}
+
+/**
+ * Find the doc ids whose titles contain every trigram of the query
+ *
+ * Candidates still need to be verified against the title, since
+ * sharing all trigrams does not guarantee a contiguous match.
+ *
+ * @param text The normalized query text, at least three characters
+ * @return the ascending candidate doc ids
+ */
+vector<unsigned int> TitleIndex::Candidates(string text) {
+    vector<unsigned int> matches;
+
+    // collect the posting list for each distinct trigram in the query
+    vector<const PostingList*> lists;
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        unordered_map<unsigned int, PostingList>::iterator it = postings.find(trigramKey(text, i));
+        if (it == postings.end()) {
+            return matches; // a trigram nobody has means no matches
+        }
+        if (find(lists.begin(), lists.end(), &it->second) == lists.end()) {
+            lists.push_back(&it->second);
+        }
+    }
+    if (lists.empty()) {
+        return matches;
+    }
+
+    // drive the intersection from the shortest list
+    sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+        return a->count < b->count;
+    });
+    vector<Cursor> cursors;
+    for (const PostingList* list : lists) {
+        cursors.push_back(Cursor(list));
+        cursors.back().Next();
+    }
+
+    // leapfrog: seek every cursor to the current candidate until they agree
+    unsigned int candidate = cursors[0].doc;
+    while (!cursors[0].done) {
+        bool agreed = true;
+        for (size_t i = 1; i < cursors.size(); ++i) {
+            cursors[i].SeekTo(candidate);
+            if (cursors[i].done) {
+                return matches;
+            }
+            if (cursors[i].doc != candidate) {
+                candidate = cursors[i].doc;
+                agreed = false;
+                break;
+            }
+        }
+
+        if (agreed) {
+            matches.push_back(candidate);
+            cursors[0].Next();
+        }
+        else {
+            cursors[0].SeekTo(candidate);
+        }
+        candidate = cursors[0].doc;
+    }
+    return matches;
+}
+
 //============================================================================
 // Linked-List class definition
 //============================================================================
@@ -47,16 +282,47 @@ private:
     struct Node {
         Bid bid;
         Node *next;
+        Node *prev;         // back link, lets a located node unlink itself
+        unsigned int docId; // position in docs, used by the title index
+        unsigned long long sequence; // when the node was indexed, never renumbered
+        Node *prevCopy;     // neighbouring nodes with the same bid id, in list
+        Node *nextCopy;     // order; only kept when the list indexes ids
 
         // default constructor
         Node() {
             next = nullptr;
+            prev = nullptr;
+            docId = 0;
+            sequence = 0;
+            prevCopy = nullptr;
+            nextCopy = nullptr;
         }
 
         // initialize with a bid
         Node(Bid aBid) {
             bid = aBid;
             next = nullptr;
+            prev = nullptr;
+            docId = 0;
+            sequence = 0;
+            prevCopy = nullptr;
+            nextCopy = nullptr;
+        }
+    };
+
+    // id index entry: the ends of the chain of nodes holding the id, and
+    // how many do
+    struct IdEntry {
+        Node* first;
+        Node* last;
+        int count;
+    };
+
+    // orders posting lists by when the node was added; keyed on the
+    // sequence rather than docId, which compaction rewrites
+    struct BySequence {
+        bool operator()(const Node* a, const Node* b) const {
+            return a->sequence < b->sequence;
         }
     };
 
@@ -64,15 +330,61 @@ private:
     Node* tail;
     int size = 0;
 
+    // secondary indexes, kept in step with the list on Append/Prepend/Remove
+    map<string, set<Node*, BySequence>> fundIndex;  // fund -> posting list of nodes
+    multimap<double, Node*> amountIndex;   // amount -> node, ordered by amount
+
+    // full-text index over titles; removed nodes leave a nullptr in docs
+    // until enough pile up to compact it
+    TitleIndex titleIndex;
+    vector<Node*> docs;
+    unsigned int removedDocs = 0;
+    unsigned long long nextSequence = 0;
+
+    // optional bidId -> node index giving O(1) Search, Remove and Touch
+    bool indexById = false;
+    unordered_map<string, IdEntry> idIndex;
+
+    // optional filter answering most lookups for absent ids without a scan
+    BloomFilter* bloom = nullptr;
+
+#ifdef BID_STATS
+    ContainerStats stats;
+#endif
+
+    Node* findNode(string bidId);
+    static void linkCopy(IdEntry& entry, Node* node, bool atFront);
+    static void unlinkCopy(IdEntry& entry, Node* node);
+    void unlinkNode(Node* node);
+    void indexNode(Node* node, bool atFront);
+    void unindexNode(Node* node);
+    void compactTitleIndex();
+    void rebuildBloom(size_t expectedBids);
+
 public:
     LinkedList();
+    LinkedList(bool withIdIndex);
     virtual ~LinkedList();
     void Append(Bid bid);
+    void Insert(Bid bid);
     void Prepend(Bid bid);
     void PrintList();
+    void PrintAll();
+    void Export(ostream& out, ExportFormat format);
     void Remove(string bidId);
     Bid Search(string bidId);
+    bool Touch(string bidId);
+    Bid Front();
+    vector<Bid> SearchByFund(string fund);
+    vector<Bid> SearchByAmount(double low, double high);
+    vector<Bid> SearchByTitle(string text);
+    void EnableBloomFilter(size_t expectedBids);
     int Size();
+#ifdef BID_STATS
+    ContainerStats& Stats() {
+        return stats;
+    }
+#endif
 };
 
 /**
@@ -84,6 +396,20 @@ LinkedList::LinkedList() {
     head = tail = nullptr;
 }
 
+/**
+ * Constructor for choosing whether to keep an id index
+ *
+ * With the index every bid id maps straight to its node, so Search,
+ * Remove and Touch no longer walk the list. That makes the list usable
+ * as an ordered, LRU-style working set at the cost of one hash entry
+ * per distinct id.
+ *
+ * @param withIdIndex true to maintain the id index
+ */
+LinkedList::LinkedList(bool withIdIndex) : LinkedList() {
+    indexById = withIdIndex;
+}
+
 /**
  * Destructor
  */
@@ -98,15 +424,18 @@ LinkedList::~LinkedList() {
         current = current->next; // make current the next node
         delete temp; // delete the orphan node
     }
+    delete bloom;
 }
 
 /**
  * Append a new bid to the end of the list
  */
 void LinkedList::Append(Bid bid) {
+    STATS_TIMER(insert);
     // FIXME (2): Implement append logic
     //Create new node
     Node* node = new Node(bid);
+    STATS_COUNT(allocations);
 
     //if there is nothing at the head...
     if (head == nullptr) {
@@ -115,31 +444,52 @@ void LinkedList::Append(Bid bid) {
     else {
         if (tail != nullptr) {
             tail->next = node; // when tail exists we set it's pointer to the new node
+            node->prev = tail; // and the new node points back at it
         }
     }
     tail = node; // new node will always be the new tail
     size++; //increase size count
-
-               
+    indexNode(node, false); // keep the secondary indexes in step
 }
 
 /**
  * Prepend a new bid to the start of the list
  */
 void LinkedList::Prepend(Bid bid) {
+    STATS_TIMER(insert);
     // FIXME (3): Implement prepend logic
     // Create new node
     Node* node = new Node(bid);
+    STATS_COUNT(allocations);
     // if there is already something at the head...
     if (head != nullptr) {
         node->next = head; // new node points to current head as its next node
+        head->prev = node; // and the old head points back at it
     }
 
     // head now becomes the new node
     head = node;
+    // an empty list also needs its tail set
+    if (tail == nullptr) {
+        tail = node;
+    }
     //increase size count
     size++;
+    indexNode(node, true); // keep the secondary indexes in step
+}
+
+/**
+ * Append a bid, under the name every bid index shares
+ */
+void LinkedList::Insert(Bid bid) {
+    Append(bid);
+}
 
+/**
+ * Print the list, under the name every bid index shares
+ */
+void LinkedList::PrintAll() {
+    PrintList();
 }
 
 /**
@@ -147,21 +497,33 @@ void LinkedList::Prepend(Bid bid) {
  */
 void LinkedList::PrintList() {
     // FIXME (4): Implement print logic
+    Export(cout, EXPORT_TEXT);
+}
+
+/**
+ * Write every bid, in list order, in one of the export formats
+ *
+ * @param out Where to write the bids
+ * @param format Text, CSV or JSON Lines
+ */
+void LinkedList::Export(ostream& out, ExportFormat format) {
+    STATS_TIMER(traverse);
     // start at the head
     Node* curNode = head;
+    vector<const Bid*> bids;
+    bids.reserve(size);
 
-    // while loop over each node looking for a match
+    // while loop over each node
     while (curNode != nullptr)
     {
+        STATS_COUNT(traverse.visited);
 
-        //output current bidID, title, amount and fund
-        cout << curNode->bid.bidId << ": ";
-        cout << curNode->bid.title << "| ";
-        cout << curNode->bid.amount << "| ";
-        cout << curNode->bid.fund << endl;
+        //collect current bidID, title, amount and fund for the export writer
+        bids.push_back(&curNode->bid);
         //set current equal to next
         curNode = curNode->next;
     }
+    exportBids(bids, out, format);
 }
 
 /**
@@ -169,89 +531,391 @@ void LinkedList::PrintList() {
  *
  * @param bidId The bid id to remove from the list
  */
-    void LinkedList::Remove(string bidId) {
-        // FIXME (5): Implement remove logic
-        Node* cursor = head;
-        Node* tempNode;
+void LinkedList::Remove(string bidId) {
+    STATS_TIMER(remove);
+    // FIXME (5): Implement remove logic
+    // locate the first match, via the id index when there is one
+    Node* node = findNode(bidId);
+    if (node == nullptr) {
+        STATS_COUNT(remove.misses);
+        return;
+    }
+    STATS_COUNT(remove.hits);
 
-        // special case if matching node is the head
-        // make head point to the next node in the list
+    // drop it from the indexes, splice it out and free it
+    unindexNode(node);
+    unlinkNode(node);
+    delete node;
+    size--; //decrease size count
+}
 
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid LinkedList::Search(string bidId) {
+    STATS_TIMER(search);
+    // FIXME (6): Implement search logic
+    Node* node = findNode(bidId);
+    if (node != nullptr) {
+        STATS_COUNT(search.hits);
+        return node->bid;
+    }
+    STATS_COUNT(search.misses);
 
+    //(the next two statements will only execute if search item is not found)
+        //create new empty bid
+        //return empty bid 
+    Bid emptyBid;
+    emptyBid.bidId = "";
+    return emptyBid;
+}
 
-            //decrease size count
-            //return
+/**
+ * Mark a bid as most recently used by moving it to the end of the list
+ *
+ * Paired with Front and Remove this gives LRU eviction: the least
+ * recently touched bid is always at the head.
+ *
+ * @param bidId The bid id to move
+ * @return true if the bid was found
+ */
+bool LinkedList::Touch(string bidId) {
+    Node* node = findNode(bidId);
+    if (node == nullptr) {
+        return false;
+    }
+    if (node == tail) {
+        return true;
+    }
 
-        // start at the head
-        // while loop over each node looking for a match
-            // if the next node bidID is equal to the current bidID
-                // hold onto the next node temporarily
-             // make current node point beyond the next node
-             // now free up memory held by temp
-             // decrease size count
-             //return
+    // the moved node becomes the last copy of its id
+    if (indexById) {
+        IdEntry& entry = idIndex[bidId];
+        if (entry.last != node) {
+            unlinkCopy(entry, node);
+            linkCopy(entry, node, false);
+        }
+    }
 
-        // current node is equal to next node
+    unlinkNode(node);
+    node->prev = tail;
+    node->next = nullptr;
+    tail->next = node;
+    tail = node;
+    return true;
+}
 
-        for (int i = 0; i < size - 1; i++) {
-            // match the head
-            if ((cursor->bid.bidId == bidId) && (i == 0)) {
-                head = cursor->next;
-                free(cursor); // free up memory
-                size--; // decrease size
-                break; // return
-            }
-            //match the tail
-            else if ((cursor->next->bid.bidId == bidId) && (cursor->next->next == nullptr)) {
-                tempNode = cursor->next; // temp hold of node
-                tail = cursor; // 
-                cursor->next = nullptr;
-                free(tempNode); // free up memory
-                size--; // decrease size
-                break; // return
-            }
-            else if (cursor->bid.bidId == bidId) {
-                tempNode = cursor->next; // temp hold of node
-                cursor->bid = tempNode->bid;
-                cursor->next = tempNode->next;
-                free(tempNode); // free up memory
-                size--; // decrease size
-                break; // return
-            }
-            cursor = cursor->next;
+/**
+ * Return the bid at the head of the list (least recently used)
+ */
+Bid LinkedList::Front() {
+    if (head == nullptr) {
+        Bid emptyBid;
+        return emptyBid;
+    }
+    return head->bid;
+}
 
+/**
+ * Put a Bloom filter in front of Search, Remove and Touch
+ *
+ * Lookups for ids the filter has never seen return without walking the
+ * list. The filter is sized for the bids already stored plus
+ * expectedBids, and is rebuilt at twice the size if the list outgrows it.
+ *
+ * @param expectedBids How many more bids are expected
+ */
+void LinkedList::EnableBloomFilter(size_t expectedBids) {
+    rebuildBloom(size + expectedBids);
+}
 
-        }
+/**
+ * Replace the Bloom filter with one sized for expectedBids, holding
+ * every stored bid
+ */
+void LinkedList::rebuildBloom(size_t expectedBids) {
+    delete bloom;
+    bloom = new BloomFilter(expectedBids);
+    for (Node* node = head; node != nullptr; node = node->next) {
+        bloom->Add(node->bid.bidId);
     }
+}
+
 /**
- * Search for the specified bidId
+ * Find the first node holding a bid id
  *
- * @param bidId The bid id to search for
+ * @param bidId The bid id to look for
+ * @return the node, or nullptr if there is none
  */
-Bid LinkedList::Search(string bidId) {
-    // FIXME (6): Implement search logic
-
-    // special case if matching bid is the head
+LinkedList::Node* LinkedList::findNode(string bidId) {
+    if (bloom != nullptr && !bloom->MayContain(bidId)) {
+        return nullptr;
+    }
+    if (indexById) {
+        STATS_COUNT(search.visited);
+        unordered_map<string, IdEntry>::iterator it = idIndex.find(bidId);
+        return it == idIndex.end() ? nullptr : it->second.first;
+    }
 
     // start at the head of the list
-    Node* cursor = head;
-
     // keep searching until end reached with while loop (current != nullptr)
-        // if the current node matches, return current bid
-        // else current node is equal to next node
+    Node* cursor = head;
     while (cursor != nullptr) {
+        STATS_COUNT(search.visited);
         if (cursor->bid.bidId == bidId) {
-            return cursor->bid;
+            return cursor;
         }
         cursor = cursor->next;
     }
+    return nullptr;
+}
 
-    //(the next two statements will only execute if search item is not found)
-        //create new empty bid
-        //return empty bid 
-    Bid emptyBid;
-    emptyBid.bidId = "";
-    return emptyBid;
+/**
+ * Add a node to either end of its id's chain of copies
+ *
+ * @param entry The id's index entry, already holding at least one node
+ * @param node The node to add
+ * @param atFront true if the node went in ahead of every other copy
+ */
+void LinkedList::linkCopy(IdEntry& entry, Node* node, bool atFront) {
+    if (atFront) {
+        node->prevCopy = nullptr;
+        node->nextCopy = entry.first;
+        entry.first->prevCopy = node;
+        entry.first = node;
+    }
+    else {
+        node->prevCopy = entry.last;
+        node->nextCopy = nullptr;
+        entry.last->nextCopy = node;
+        entry.last = node;
+    }
+}
+
+/**
+ * Take a node out of its id's chain of copies
+ *
+ * @param entry The id's index entry, holding at least one other node
+ * @param node The node to take out
+ */
+void LinkedList::unlinkCopy(IdEntry& entry, Node* node) {
+    if (node->prevCopy != nullptr) {
+        node->prevCopy->nextCopy = node->nextCopy;
+    }
+    else {
+        entry.first = node->nextCopy;
+    }
+    if (node->nextCopy != nullptr) {
+        node->nextCopy->prevCopy = node->prevCopy;
+    }
+    else {
+        entry.last = node->prevCopy;
+    }
+    node->prevCopy = nullptr;
+    node->nextCopy = nullptr;
+}
+
+/**
+ * Splice a node out of the list without freeing it
+ *
+ * @param node The node to unlink
+ */
+void LinkedList::unlinkNode(Node* node) {
+    if (node->prev != nullptr) {
+        node->prev->next = node->next;
+    }
+    else {
+        head = node->next;  // node was the head
+    }
+
+    if (node->next != nullptr) {
+        node->next->prev = node->prev;
+    }
+    else {
+        tail = node->prev;  // node was the tail
+    }
+}
+
+/**
+ * Search for all bids posted against a fund
+ *
+ * @param fund The fund to look up
+ * @return the matching bids, in the order they were added
+ */
+vector<Bid> LinkedList::SearchByFund(string fund) {
+    vector<Bid> bids;
+
+    // the posting list points straight at the nodes, no list walk needed
+    map<string, set<Node*, BySequence>>::iterator it = fundIndex.find(fund);
+    if (it == fundIndex.end()) {
+        return bids;
+    }
+    for (Node* node : it->second) {
+        bids.push_back(node->bid);
+    }
+    return bids;
+}
+
+/**
+ * Search for all bids whose amount falls within a range
+ *
+ * @param low The lowest amount to include
+ * @param high The highest amount to include
+ * @return the matching bids, ordered by amount
+ */
+vector<Bid> LinkedList::SearchByAmount(double low, double high) {
+    vector<Bid> bids;
+
+    // walk only the slice of the amount index inside [low, high]
+    multimap<double, Node*>::iterator it = amountIndex.lower_bound(low);
+    multimap<double, Node*>::iterator end = amountIndex.upper_bound(high);
+    for (; it != end; ++it) {
+        bids.push_back(it->second->bid);
+    }
+    return bids;
+}
+
+/**
+ * Search for all bids whose title contains some text
+ *
+ * Queries of three or more characters are answered from the trigram
+ * index; shorter ones have no trigram to look up and scan the titles.
+ *
+ * @param text The text to look for, case-insensitive
+ * @return the matching bids, in insertion order
+ */
+vector<Bid> LinkedList::SearchByTitle(string text) {
+    vector<Bid> bids;
+    text = TitleIndex::Normalize(text);
+
+    if (text.size() < 3) {
+        for (Node* node : docs) {
+            if (node != nullptr && TitleIndex::Normalize(node->bid.title).find(text) != string::npos) {
+                bids.push_back(node->bid);
+            }
+        }
+        return bids;
+    }
+
+    // verify each candidate, dropping removed docs and non-contiguous matches
+    vector<unsigned int> candidates = titleIndex.Candidates(text);
+    for (unsigned int docId : candidates) {
+        Node* node = docs[docId];
+        if (node != nullptr && TitleIndex::Normalize(node->bid.title).find(text) != string::npos) {
+            bids.push_back(node->bid);
+        }
+    }
+    return bids;
+}
+
+/**
+ * Add a node to the secondary indexes
+ *
+ * @param node The node that was just linked into the list
+ * @param atFront true if the node went in ahead of every other node
+ */
+void LinkedList::indexNode(Node* node, bool atFront) {
+    if (indexById) {
+        // the id index chains every copy of an id, earliest first
+        unordered_map<string, IdEntry>::iterator it = idIndex.find(node->bid.bidId);
+        if (it == idIndex.end()) {
+            IdEntry entry;
+            entry.first = node;
+            entry.last = node;
+            entry.count = 1;
+            idIndex[node->bid.bidId] = entry;
+        }
+        else {
+            linkCopy(it->second, node, atFront);
+            it->second.count++;
+        }
+    }
+
+    // doc ids only ever grow, which keeps the title postings ascending
+    node->docId = (unsigned int)docs.size();
+    docs.push_back(node);
+    titleIndex.Add(node->docId, node->bid.title);
+
+    node->sequence = nextSequence++;
+    fundIndex[node->bid.fund].insert(node);
+    amountIndex.insert(make_pair(node->bid.amount, node));
+
+    // grow the filter once the list outgrows what it was sized for
+    if (bloom != nullptr) {
+        if ((size_t)size > bloom->Capacity()) {
+            rebuildBloom(size * 2);
+        }
+        else {
+            bloom->Add(node->bid.bidId);
+        }
+    }
+}
+
+/**
+ * Drop a node from the secondary indexes
+ *
+ * @param node The node that is about to be unlinked
+ */
+void LinkedList::unindexNode(Node* node) {
+    if (indexById) {
+        unordered_map<string, IdEntry>::iterator it = idIndex.find(node->bid.bidId);
+        if (it != idIndex.end()) {
+            if (--it->second.count == 0) {
+                idIndex.erase(it);
+            }
+            else {
+                unlinkCopy(it->second, node);
+            }
+        }
+    }
+
+    docs[node->docId] = nullptr; // title postings skip removed docs
+    ++removedDocs;
+    map<string, set<Node*, BySequence>>::iterator fund = fundIndex.find(node->bid.fund);
+    if (fund != fundIndex.end()) {
+        set<Node*, BySequence>& postings = fund->second;
+        postings.erase(node);
+        if (postings.empty()) {
+            fundIndex.erase(fund);
+        }
+    }
+
+    pair<multimap<double, Node*>::iterator, multimap<double, Node*>::iterator> range =
+        amountIndex.equal_range(node->bid.amount);
+    for (multimap<double, Node*>::iterator it = range.first; it != range.second; ++it) {
+        if (it->second == node) {
+            amountIndex.erase(it);
+            break;
+        }
+    }
+
+    if (removedDocs >= COMPACT_MIN_REMOVED && removedDocs * 2 > docs.size()) {
+        compactTitleIndex();
+    }
+}
+
+/**
+ * Drop the removed docs and rebuild the title postings over the live ones
+ *
+ * Only docId is renumbered; the fund postings are ordered by sequence
+ * and are left alone. Each rebuild follows at least as many removals as
+ * there are live docs, so its cost is amortized over them.
+ */
+void LinkedList::compactTitleIndex() {
+    vector<Node*> live;
+    live.reserve(docs.size() - removedDocs);
+    titleIndex = TitleIndex();
+    for (Node* node : docs) {
+        if (node != nullptr) {
+            node->docId = (unsigned int)live.size();
+            live.push_back(node);
+            titleIndex.Add(node->docId, node->bid.title);
+        }
+    }
+    docs.swap(live);
+    removedDocs = 0;
 }
 
 /**
@@ -262,20 +926,243 @@ int LinkedList::Size() {
 }
 
 //============================================================================
-// Static methods used for testing
+// Unrolled Linked-List class definition
 //============================================================================
 
 /**
- * Display the bid information
+ * Define a class containing data members and methods to
+ * implement an unrolled linked-list.
+ *
+ * Each node holds up to CHUNK_CAPACITY bids packed at the front of an
+ * array, so a scan touches consecutive memory and follows one pointer
+ * per chunk instead of one per bid. Same interface and semantics as
+ * LinkedList: Append/Prepend keep insertion order, Remove drops the
+ * first match and Search returns the first match.
+ */
+class UnrolledLinkedList {
+
+private:
+    static const int CHUNK_CAPACITY = 8;
+
+    //Internal structure for list chunks, housekeeping variables
+    struct Chunk {
+        Bid bids[CHUNK_CAPACITY];
+        int count;
+        Chunk *next;
+
+        // default constructor
+        Chunk() {
+            count = 0;
+            next = nullptr;
+        }
+    };
+
+    Chunk* head;
+    Chunk* tail;
+    int size = 0;
+
+public:
+    UnrolledLinkedList();
+    virtual ~UnrolledLinkedList();
+    void Append(Bid bid);
+    void Insert(Bid bid);
+    void Prepend(Bid bid);
+    void PrintList();
+    void PrintAll();
+    void Export(ostream& out, ExportFormat format);
+    void Remove(string bidId);
+    Bid Search(string bidId);
+    int Size();
+};
+
+/**
+ * Default constructor
+ */
+UnrolledLinkedList::UnrolledLinkedList() {
+    head = tail = nullptr;
+}
+
+/**
+ * Destructor
+ */
+UnrolledLinkedList::~UnrolledLinkedList() {
+    // loop over each chunk, detach from list then delete
+    Chunk* current = head;
+    while (current != nullptr) {
+        Chunk* temp = current;
+        current = current->next;
+        delete temp;
+    }
+}
+
+/**
+ * Append a new bid to the end of the list
+ */
+void UnrolledLinkedList::Append(Bid bid) {
+    // start a new chunk when there is none or the tail is full
+    if (tail == nullptr || tail->count == CHUNK_CAPACITY) {
+        Chunk* chunk = new Chunk();
+        if (tail == nullptr) {
+            head = chunk;
+        }
+        else {
+            tail->next = chunk;
+        }
+        tail = chunk;
+    }
+
+    tail->bids[tail->count++] = bid;
+    size++;
+}
+
+/**
+ * Prepend a new bid to the start of the list
+ */
+void UnrolledLinkedList::Prepend(Bid bid) {
+    // start a new chunk when there is none or the head is full
+    if (head == nullptr || head->count == CHUNK_CAPACITY) {
+        Chunk* chunk = new Chunk();
+        chunk->next = head;
+        head = chunk;
+        if (tail == nullptr) {
+            tail = chunk;
+        }
+    }
+
+    // shuffle the head chunk up one slot to open the front
+    for (int i = head->count; i > 0; --i) {
+        head->bids[i] = move(head->bids[i - 1]);
+    }
+    head->bids[0] = bid;
+    head->count++;
+    size++;
+}
+
+/**
+ * Append a bid, under the name every bid index shares
+ */
+void UnrolledLinkedList::Insert(Bid bid) {
+    Append(bid);
+}
+
+/**
+ * Print the list, under the name every bid index shares
+ */
+void UnrolledLinkedList::PrintAll() {
+    PrintList();
+}
+
+/**
+ * Simple output of all bids in the list
+ */
+void UnrolledLinkedList::PrintList() {
+    Export(cout, EXPORT_TEXT);
+}
+
+/**
+ * Write every bid, in list order, in one of the export formats
  *
- * @param bid struct containing the bid info
+ * @param out Where to write the bids
+ * @param format Text, CSV or JSON Lines
  */
-void displayBid(Bid bid) {
-    cout << bid.bidId << ": " << bid.title << " | " << bid.amount
-         << " | " << bid.fund << endl;
-    return;
+void UnrolledLinkedList::Export(ostream& out, ExportFormat format) {
+    vector<const Bid*> bids;
+    bids.reserve(size);
+    for (Chunk* chunk = head; chunk != nullptr; chunk = chunk->next) {
+        for (int i = 0; i < chunk->count; ++i) {
+            bids.push_back(&chunk->bids[i]);
+        }
+    }
+    exportBids(bids, out, format);
+}
+
+/**
+ * Remove a specified bid
+ *
+ * Emptied chunks are unlinked, and a chunk left under half full is
+ * merged with its successor when both fit in one, which keeps scans
+ * dense after heavy removal.
+ *
+ * @param bidId The bid id to remove from the list
+ */
+void UnrolledLinkedList::Remove(string bidId) {
+    Chunk* prev = nullptr;
+
+    for (Chunk* chunk = head; chunk != nullptr; prev = chunk, chunk = chunk->next) {
+        for (int i = 0; i < chunk->count; ++i) {
+            if (chunk->bids[i].bidId != bidId) {
+                continue;
+            }
+
+            // close the gap inside the chunk
+            for (int j = i; j < chunk->count - 1; ++j) {
+                chunk->bids[j] = move(chunk->bids[j + 1]);
+            }
+            chunk->bids[--chunk->count] = Bid();
+            size--;
+
+            // unlink a chunk that is now empty
+            if (chunk->count == 0) {
+                if (prev == nullptr) {
+                    head = chunk->next;
+                }
+                else {
+                    prev->next = chunk->next;
+                }
+                if (tail == chunk) {
+                    tail = prev;
+                }
+                delete chunk;
+                return;
+            }
+
+            // fold the next chunk in when the two fit together
+            Chunk* next = chunk->next;
+            if (next != nullptr && chunk->count < CHUNK_CAPACITY / 2
+                && chunk->count + next->count <= CHUNK_CAPACITY) {
+                for (int j = 0; j < next->count; ++j) {
+                    chunk->bids[chunk->count++] = move(next->bids[j]);
+                }
+                chunk->next = next->next;
+                if (tail == next) {
+                    tail = chunk;
+                }
+                delete next;
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * Search for the specified bidId
+ *
+ * @param bidId The bid id to search for
+ */
+Bid UnrolledLinkedList::Search(string bidId) {
+    for (Chunk* chunk = head; chunk != nullptr; chunk = chunk->next) {
+        for (int i = 0; i < chunk->count; ++i) {
+            if (chunk->bids[i].bidId == bidId) {
+                return chunk->bids[i];
+            }
+        }
+    }
+
+    Bid emptyBid;
+    return emptyBid;
+}
+
+/**
+ * Returns the current size (number of elements) in the list
+ */
+int UnrolledLinkedList::Size() {
+    return size;
 }
 
+//============================================================================
+// Static methods used for testing
+//============================================================================
+
 /**
  * Prompt user for bid information
  *
@@ -304,48 +1191,88 @@ Bid getBid() {
 }
 
 /**
- * Load a CSV file containing bids into a LinkedList
- *
- * @return a LinkedList containing all the bids read
+ * Create the empty list each load of the bid file starts from
  */
-void loadBids(string csvPath, LinkedList *list) {
-    cout << "Loading CSV file " << csvPath << endl;
-
-    // initialize the CSV Parser
-    csv::Parser file = csv::Parser(csvPath);
-
-    try {
-        // loop to read rows of a CSV file
-        for (unsigned int i = 0; i < file.rowCount(); i++) {
-
-            // initialize a bid using data from current row (i)
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.fund = file[i][8];
-            bid.amount = strToDouble(file[i][4], '$');
-
-            //cout << bid.bidId << ": " << bid.title << " | " << bid.fund << " | " << bid.amount << endl;
+LinkedList* newBidList() {
+    LinkedList* list = new LinkedList(true);
+    list->EnableBloomFilter(EXPECTED_BIDS);
+    return list;
+}
 
-            // add this bid to the end
-            list->Append(bid);
+/**
+ * Use an indexed list as an LRU working set: look each bid up with
+ * Touch, add it on a miss and evict from the Front once the set is full
+ *
+ * Accesses are skewed, four in five going to a hot fifth of the bids,
+ * and the working set holds a tenth of them.
+ *
+ * @param options Sweep size, repetitions and operation counts
+ */
+void benchmarkWorkingSet(const BenchmarkOptions& options) {
+    for (unsigned int bids = 1000; bids <= options.maxBids; bids *= 10) {
+        vector<Bid> data = makeBenchmarkBids(bids, bids);
+        unsigned int capacity = bids / 10;
+        unsigned int hot = max(1u, bids / 5);
+        unsigned int accesses = options.operations * 10;
+
+        vector<double> samples;
+        unsigned long hits = 0, total = 0;
+        mt19937 generator(bids);
+
+        for (unsigned int run = 0; run <= options.repetitions; ++run) {
+            bool warmup = run == 0;
+            LinkedList list(true);
+            for (unsigned int i = 0; i < accesses; ++i) {
+                const Bid& bid = data[generator() % 5 != 0 ? generator() % hot : generator() % bids];
+                long long start = nowNanos();
+                bool hit = list.Touch(bid.bidId);
+                if (!hit) {
+                    list.Append(bid);
+                    if ((unsigned int)list.Size() > capacity) {
+                        list.Remove(list.Front().bidId);
+                    }
+                }
+                long long elapsed = nowNanos() - start;
+                if (!warmup) {
+                    samples.push_back((double)elapsed);
+                    hits += hit;
+                    total++;
+                }
+            }
         }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
+
+        reportSamples("LinkedList(LRU)", bids, "access", samples);
+        printf("%-22s %9u  %-12s %12.1f %% of accesses hit a working set of %u\n", "LinkedList(LRU)", bids,
+            "hit rate", total > 0 ? 100.0 * hits / total : 0.0, capacity);
+        fflush(stdout);
     }
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
- *
- * credit: http://stackoverflow.com/a/24875936
- *
- * @param ch The character to strip out
+ * Run the benchmark sweep over both list layouts and, as a baseline,
+ * the plain vector the sorting lab keeps its bids in, then the indexed
+ * list as an LRU working set
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+void runBenchmarks(const BenchmarkOptions& options) {
+    printBenchmarkHeader(options);
+
+    benchmarkIndex<LinkedList>("LinkedList", options, true);
+
+    benchmarkIndex<LinkedList>("LinkedList+bloom", options, true,
+        [](unsigned int bids) {
+            LinkedList* list = new LinkedList();
+            list->EnableBloomFilter(bids);
+            return list;
+        });
+
+    benchmarkIndex<LinkedList>("LinkedList(indexed)", options, false,
+        [](unsigned int) { return new LinkedList(true); });
+
+    benchmarkIndex<UnrolledLinkedList>("UnrolledLinkedList", options, true);
+
+    benchmarkIndex<BidVector>("vector<Bid>", options, true);
+
+    benchmarkWorkingSet(options);
 }
 
 /**
@@ -356,6 +1283,19 @@ double strToDouble(string str, char ch) {
  */
 int main(int argc, char* argv[]) {
 
+    // non-interactive benchmark sweep
+    if (argc >= 2 && string(argv[1]) == "--benchmark") {
+        runBenchmarks(parseBenchmarkOptions(argc, argv));
+        return 0;
+    }
+
+    // non-interactive batch of operations: --batch [operations] [results]
+    if (argc >= 2 && string(argv[1]) == "--batch") {
+        LinkedList list(true);
+        list.EnableBloomFilter(EXPECTED_BIDS);
+        return runBatchCommand(argc, argv, &list);
+    }
+
     // process command line arguments
     string csvPath, bidKey;
     switch (argc) {
@@ -374,42 +1314,83 @@ int main(int argc, char* argv[]) {
 
     clock_t ticks;
 
-    LinkedList bidList;
+    // each reload publishes a new list and every command pins the one it works on
+    SnapshotStore<LinkedList> lists(newBidList());
 
     Bid bid;
 
+    // Load Bids reads the file once, then follows rows appended to it
+    BidFileFollower follower(csvPath);
+    BackgroundLoader<LinkedList> loader;
+    bool following = false;
+
     int choice = 0;
     while (choice != 9) {
         cout << "Menu:" << endl;
         cout << "  1. Enter a Bid" << endl;
-        cout << "  2. Load Bids" << endl;
+        cout << "  2. Load Bids";
+        if (loader.Running()) {
+            cout << " (" << loader.Percent() << "% loaded)";
+        }
+        cout << endl;
         cout << "  3. Display All Bids" << endl;
         cout << "  4. Find Bid" << endl;
         cout << "  5. Remove Bid" << endl;
+        cout << "  6. Find Bids by Fund" << endl;
+        cout << "  7. Find Bids by Amount" << endl;
+        cout << "  8. Search Bid Titles" << endl;
         cout << "  9. Exit" << endl;
+#ifdef BID_STATS
+        cout << " 10. Show Statistics" << endl;
+#endif
         cout << "Enter choice: ";
         cin >> choice;
 
+        // publish a finished load, or pick up rows appended while waiting
+        if (following && choice != 2) {
+            followSnapshot(lists, follower, loader, newBidList);
+        }
+        shared_ptr<LinkedList> current = lists.Pin();
+        LinkedList& bidList = *current;
+
         switch (choice) {
         case 1:
+            // the list being loaded would not see the new bid
+            if (loader.Running()) {
+                cout << "a load is in progress, enter the bid once it finishes" << endl;
+                break;
+            }
             bid = getBid();
             bidList.Append(bid);
             displayBid(bid);
 
             break;
 
-        case 2:
-            ticks = clock();
-
-            loadBids(csvPath, &bidList);
-
-            cout << bidList.Size() << " bids read" << endl;
-
-            ticks = clock() - ticks; // current clock ticks minus starting clock ticks
-            cout << "time: " << ticks << " milliseconds" << endl;
-            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+        case 2: {
+
+            // a load still running reports its progress and may be cancelled
+            if (loader.Running() && !loader.Finished()) {
+                loader.PrintProgress(cout);
+                cout << "Cancel the load? (y/n) ";
+                string answer;
+                cin >> answer;
+                if (answer == "y" || answer == "Y") {
+                    loader.Cancel();
+                }
+                break;
+            }
 
+            // the first load reads the whole file in the background while
+            // the menu keeps serving the current version, later ones only
+            // appended rows
+            long loaded = followSnapshot(lists, follower, loader, newBidList);
+            if (loaded < 0) {
+                cout << "could not read " << csvPath << endl;
+                break;
+            }
+            following = true;
             break;
+        }
 
         case 3:
             bidList.PrintList();
@@ -435,9 +1416,82 @@ int main(int argc, char* argv[]) {
             break;
 
         case 5:
+            // the list being loaded would not see the removal
+            if (loader.Running()) {
+                cout << "a load is in progress, remove the bid once it finishes" << endl;
+                break;
+            }
             bidList.Remove(bidKey);
 
             break;
+
+        case 6: {
+            string fund;
+            cout << "Enter fund: ";
+            cin.ignore();
+            getline(cin, fund);
+
+            ticks = clock();
+            vector<Bid> matches = bidList.SearchByFund(fund);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+            break;
+        }
+
+        case 7: {
+            double low, high;
+            cout << "Enter lowest amount: ";
+            cin >> low;
+            cout << "Enter highest amount: ";
+            cin >> high;
+
+            ticks = clock();
+            vector<Bid> matches = bidList.SearchByAmount(low, high);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+            break;
+        }
+
+        case 8: {
+            string text;
+            cout << "Enter title text: ";
+            cin.ignore();
+            getline(cin, text);
+
+            ticks = clock();
+            vector<Bid> matches = bidList.SearchByTitle(text);
+            ticks = clock() - ticks;
+
+            for (unsigned int i = 0; i < matches.size(); ++i) {
+                displayBid(matches[i]);
+            }
+            cout << matches.size() << " bids found" << endl;
+            cout << "time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
+
+            break;
+        }
+
+#ifdef BID_STATS
+        case 10: {
+            bidList.Stats().Print("LinkedList");
+            ofstream json("LinkedList_stats.json");
+            bidList.Stats().WriteJson(json, "LinkedList");
+            cout << "statistics written to LinkedList_stats.json" << endl;
+            break;
+        }
+#endif
         }
     }
 
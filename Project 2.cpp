@@ -6,23 +6,23 @@
 
 
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <map>
-
-// helper function for case senstivity during search
-// converts string to uppercase
-std::string toUpperCase(const std::string& str) {
-    std::string upperStr = str;
-    for (auto& c : upperStr) {
-        c = std::toupper(c);
-    }
-    return upperStr;
-}
-
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <memory>
+#include <random>
+#include <cstdlib>
 
 // Struct to hold course data
 struct Course {
@@ -31,43 +31,911 @@ struct Course {
     std::vector<std::string> prerequisites;
 };
 
-// TreeNode struct for binary search tree
-struct TreeNode {
-    Course course;
-    TreeNode* leftChild = nullptr;
-    TreeNode* rightChild = nullptr;
+// Compressed radix trie used for type-ahead on course numbers
+// each edge holds a run of characters and children stay sorted by first character,
+// so walking below a prefix visits keys in order and can stop after k of them
+class PrefixTrie {
+public:
+    PrefixTrie() : root(new Node()) {}
+    ~PrefixTrie() { destroy(root); }
+
+    // insert a key, splitting an edge where the key diverges from it
+    void insert(const std::string& key, const std::string& value) {
+        Node* node = root;
+        size_t i = 0;
+        while (i < key.size()) {
+            size_t pos;
+            Node* child = findChild(node, key[i], pos);
+            if (child == nullptr) { // nothing shares this character, add a leaf
+                Node* leaf = new Node();
+                leaf->label = key.substr(i);
+                node->children.insert(node->children.begin() + pos, leaf);
+                node = leaf;
+                break;
+            }
+            size_t common = 0;
+            while (common < child->label.size() && i + common < key.size()
+                && child->label[common] == key[i + common]) {
+                ++common;
+            }
+            if (common < child->label.size()) { // split the edge
+                Node* middle = new Node();
+                middle->label = child->label.substr(0, common);
+                child->label = child->label.substr(common);
+                middle->children.push_back(child);
+                node->children[pos] = middle;
+                child = middle;
+            }
+            node = child;
+            i += common;
+        }
+        if (!node->isKey) {
+            node->isKey = true;
+            node->value = value;
+        }
+    }
+
+    // return up to k values whose keys start with prefix, in key order
+    std::vector<std::string> complete(const std::string& prefix, size_t k) const {
+        std::vector<std::string> out;
+        Node* node = root;
+        size_t i = 0;
+        while (i < prefix.size()) { // the last edge may run past the prefix
+            size_t pos;
+            node = findChild(node, prefix[i], pos);
+            if (node == nullptr) {
+                return out;
+            }
+            size_t length = std::min(node->label.size(), prefix.size() - i);
+            if (node->label.compare(0, length, prefix, i, length) != 0) {
+                return out;
+            }
+            i += length;
+        }
+        collect(node, out, k);
+        return out;
+    }
+
+    // drop every key
+    void clear() {
+        destroy(root);
+        root = new Node();
+    }
+
+private:
+    struct Node {
+        std::string label;            // characters on the edge into this node
+        std::vector<Node*> children;  // sorted by label[0]
+        bool isKey = false;
+        std::string value;
+    };
+
+    Node* root;
 
-    TreeNode(Course c) : course(c) {}
+    PrefixTrie(const PrefixTrie&) = delete;
+    PrefixTrie& operator=(const PrefixTrie&) = delete;
+
+    static Node* findChild(Node* node, char c, size_t& pos) {
+        auto it = std::lower_bound(node->children.begin(), node->children.end(), c,
+            [](Node* child, char ch) { return child->label[0] < ch; });
+        pos = it - node->children.begin();
+        return (it != node->children.end() && (*it)->label[0] == c) ? *it : nullptr;
+    }
+
+    static void collect(Node* node, std::vector<std::string>& out, size_t k) {
+        if (out.size() >= k) {
+            return;
+        }
+        if (node->isKey) {
+            out.push_back(node->value);
+        }
+        for (Node* child : node->children) {
+            collect(child, out, k);
+            if (out.size() >= k) {
+                return;
+            }
+        }
+    }
+
+    static void destroy(Node* node) {
+        for (Node* child : node->children) {
+            destroy(child);
+        }
+        delete node;
+    }
 };
 
-//  insert a course object into the binary search tree
-TreeNode* insertIntoBinarySearchTree(TreeNode* root, Course course) {
-    if (root == nullptr) {
-        return new TreeNode(course);
+// span of a course number left once surrounding blanks and a CR are dropped
+void trimCourseNumber(const std::string& courseNumber, size_t& begin, size_t& end) {
+    auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+    begin = 0;
+    end = courseNumber.size();
+    while (begin < end && blank(courseNumber[begin])) {
+        ++begin;
     }
-    if (course.courseNumber < root->course.courseNumber) {
-        root->leftChild = insertIntoBinarySearchTree(root->leftChild, course);
+    while (end > begin && blank(courseNumber[end - 1])) {
+        --end;
     }
-    else {
-        root->rightChild = insertIntoBinarySearchTree(root->rightChild, course);
+}
+
+inline char foldCase(char c) {
+    return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+// course number as the catalog keys it: surrounding blanks and a CR dropped, upper-cased
+// one pass straight into the result, since every lookup pays for it
+std::string normalizeCourseNumber(const std::string& courseNumber) {
+    size_t begin, end;
+    trimCourseNumber(courseNumber, begin, end);
+    std::string key(end - begin, '\0');
+    for (size_t i = begin; i < end; ++i) {
+        key[i - begin] = foldCase(courseNumber[i]);
+    }
+    return key;
+}
+
+// Course numbers packed into one 64-bit key
+// a normalized number of up to ten digits and capital letters ("CSCI300") packs six bits per
+// character from the top, 0 past the end, then digits, then letters, so keys order exactly as
+// the strings do and compare as one integer; any other number packs up to its first character
+// that does not fit, then a marker for where that character sorts (below the digits, between
+// digits and letters, or above the letters) and sets the low bit, so it still orders correctly
+// against every packed number, and two such keys that tie fall back to comparing their
+// normalized strings
+const int PACKED_CHARACTERS = 10;
+const uint64_t UNPACKED_TAIL = 1;
+const uint64_t BELOW_DIGITS = 1;
+const uint64_t FIRST_DIGIT = 2;
+const uint64_t BETWEEN_DIGITS_AND_LETTERS = FIRST_DIGIT + 10;
+const uint64_t FIRST_LETTER = BETWEEN_DIGITS_AND_LETTERS + 1;
+const uint64_t ABOVE_LETTERS = FIRST_LETTER + 26;
+
+// pack a raw course number, trimming and case-folding it on the way
+uint64_t packCourseNumber(const std::string& courseNumber) {
+    size_t begin, end;
+    trimCourseNumber(courseNumber, begin, end);
+    uint64_t key = 0;
+    int shift = 64 - 6;
+    for (size_t i = begin; i < end; ++i, shift -= 6) {
+        if (i - begin == PACKED_CHARACTERS) {
+            return key | UNPACKED_TAIL;
+        }
+        unsigned char c = (unsigned char)foldCase(courseNumber[i]); // strings compare bytes unsigned
+        if (c >= '0' && c <= '9') {
+            key |= (FIRST_DIGIT + (c - '0')) << shift;
+        }
+        else if (c >= 'A' && c <= 'Z') {
+            key |= (FIRST_LETTER + (c - 'A')) << shift;
+        }
+        else {
+            uint64_t marker = c < '0' ? BELOW_DIGITS : c < 'A' ? BETWEEN_DIGITS_AND_LETTERS : ABOVE_LETTERS;
+            return key | (marker << shift) | UNPACKED_TAIL;
+        }
+    }
+    return key;
+}
+
+inline bool packedExactly(uint64_t key) {
+    return (key & UNPACKED_TAIL) == 0;
+}
+
+// position of the lowest set bit of a non-zero word
+inline int lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// Read-only course catalog in one flat array
+// courses are moved in while loading and sorted once by seal(); lookups then search their packed
+// keys laid out in Eytzinger (breadth-first) order, where the children of slot k sit at 2k and
+// 2k+1, so every level of the search is one integer compare with no branch to mispredict and the
+// next levels can be prefetched before they are needed
+// the menu looks courses up through the CourseHashIndex built over the array; "--benchmark"
+// times this search against it and against a pointer tree
+class FlatCatalog {
+public:
+    void add(Course&& course) { courses.push_back(std::move(course)); }
+
+    // sort the courses and build the search layout; call once, after the last add()
+    void seal();
+
+    // the course with this number (blanks and case ignored), or nullptr
+    const Course* find(const std::string& courseNumber) const;
+
+    // every course, in course order
+    const std::vector<Course>& sorted() const { return courses; }
+
+    // for a key with UNPACKED_TAIL set: the course numbered courseNumber in the run of courses
+    // sharing key that starts at first, or nullptr
+    const Course* matchUnpacked(size_t first, uint64_t key, const std::string& courseNumber) const;
+
+private:
+    std::vector<Course> courses;    // sorted by packed key, then normalized number
+    std::vector<uint64_t> keys;     // packed keys in Eytzinger order from slot 1; slot 0 unused
+    std::vector<uint32_t> position; // Eytzinger slot -> index in courses
+
+    // the 16 slots four levels below k start at 16k and span two cache lines; fetch the first
+    // while the levels above are compared
+    static const size_t PREFETCH_AHEAD = 16;
+
+    size_t layOut(size_t next, size_t slot, const std::vector<uint64_t>& sortedKeys);
+};
+
+void FlatCatalog::seal() {
+    // decorate with the packed key so each number is canonicalized once; a stable sort keeps a
+    // repeated course number in file order, and the search finds the first of them
+    std::vector<std::pair<uint64_t, uint32_t>> order;
+    order.reserve(courses.size());
+    for (size_t i = 0; i < courses.size(); ++i) {
+        order.emplace_back(packCourseNumber(courses[i].courseNumber), (uint32_t)i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [this](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+            if (a.first != b.first || packedExactly(a.first)) {
+                return a.first < b.first;
+            }
+            return normalizeCourseNumber(courses[a.second].courseNumber)
+                < normalizeCourseNumber(courses[b.second].courseNumber);
+        });
+
+    std::vector<Course> sortedCourses;
+    std::vector<uint64_t> sortedKeys;
+    sortedCourses.reserve(courses.size());
+    sortedKeys.reserve(courses.size());
+    for (const std::pair<uint64_t, uint32_t>& entry : order) {
+        sortedCourses.push_back(std::move(courses[entry.second]));
+        sortedKeys.push_back(entry.first);
+    }
+    courses.swap(sortedCourses);
+
+    keys.assign(courses.size() + 1, 0);
+    position.assign(courses.size() + 1, 0);
+    layOut(0, 1, sortedKeys);
+}
+
+// an in-order walk of the implicit tree visits the slots in sorted order
+size_t FlatCatalog::layOut(size_t next, size_t slot, const std::vector<uint64_t>& sortedKeys) {
+    if (slot < keys.size()) {
+        next = layOut(next, 2 * slot, sortedKeys);
+        keys[slot] = sortedKeys[next];
+        position[slot] = (uint32_t)next;
+        next = layOut(next + 1, 2 * slot + 1, sortedKeys);
+    }
+    return next;
+}
+
+const Course* FlatCatalog::find(const std::string& courseNumber) const {
+    uint64_t key = packCourseNumber(courseNumber);
+    size_t n = keys.size() - (keys.empty() ? 0 : 1);
+    size_t slot = 1;
+    while (slot <= n) {
+#if defined(__GNUC__)
+        if (slot * PREFETCH_AHEAD <= n) {
+            __builtin_prefetch(keys.data() + slot * PREFETCH_AHEAD);
+        }
+#endif
+        slot = 2 * slot + (keys[slot] < key); // go right while the slot is smaller
+    }
+    // undo the right turns taken after the last left one; that left turn was at the lower bound
+    slot >>= lowestBit(~(uint64_t)slot) + 1;
+    if (slot == 0 || keys[slot] != key) {
+        return nullptr;
+    }
+    if (packedExactly(key)) {
+        return &courses[position[slot]];
+    }
+    return matchUnpacked(position[slot], key, courseNumber);
+}
+
+// the run of courses sharing an unpacked key is in string order, so it is binary searched; a run
+// can be long when many numbers share their first ten characters
+const Course* FlatCatalog::matchUnpacked(size_t first, uint64_t key, const std::string& courseNumber) const {
+    std::string number = normalizeCourseNumber(courseNumber);
+    std::vector<Course>::const_iterator found = std::lower_bound(courses.begin() + first, courses.end(), number,
+        [key](const Course& course, const std::string& wanted) {
+            uint64_t courseKey = packCourseNumber(course.courseNumber);
+            return courseKey != key ? courseKey < key : normalizeCourseNumber(course.courseNumber) < wanted;
+        });
+    if (found == courses.end() || packCourseNumber(found->courseNumber) != key
+        || normalizeCourseNumber(found->courseNumber) != number) {
+        return nullptr;
+    }
+    return &*found;
+}
+
+// 64-bit finalizer from splitmix64: every input bit affects every output bit
+inline uint64_t mixBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Minimal perfect hash over the packed keys of a sealed catalog
+// keys are hashed into buckets of about four; bucket by bucket, largest first, a pilot value is
+// searched for that sends every key of the bucket to its own free slot, so once built the n
+// distinct keys fill exactly n slots with no collisions (the PTHash variant of CHD); a lookup is
+// one pilot read and one slot read, and the key stored in the slot confirms membership
+class CourseHashIndex {
+public:
+    // index every distinct course number of catalog, which must outlive the index
+    void build(const FlatCatalog& catalog);
+
+    // the course with this number (blanks and case ignored), or nullptr
+    const Course* find(const std::string& courseNumber) const;
+
+private:
+    struct Slot {
+        uint64_t key;    // packed course number stored here
+        uint32_t course; // index of its first course in the catalog
+    };
+
+    const FlatCatalog* catalog = nullptr;
+    uint64_t seed = 0;
+    std::vector<uint32_t> pilots; // bucket -> pilot
+    std::vector<Slot> slots;
+
+    // keys per bucket: fewer buckets mean fewer pilots to store and longer searches to place them
+    static const size_t KEYS_PER_BUCKET = 4;
+    // give up on a seed once a bucket needs this many pilots, and start over with the next one
+    static const uint32_t MAX_PILOT = 1u << 24;
+
+    size_t bucketOf(uint64_t hash) const { return hash % pilots.size(); }
+    // mixed again after the xor, or keys whose hashes agree in the low bits could never be split
+    size_t slotOf(uint64_t hash, uint32_t pilot) const { return mixBits(hash ^ (pilot + seed)) % slots.size(); }
+    bool place(const std::vector<std::pair<uint64_t, uint32_t>>& keys);
+};
+
+void CourseHashIndex::build(const FlatCatalog& courses) {
+    catalog = &courses;
+
+    // one entry per distinct key: equal keys are adjacent, and the first of them is kept
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+    const std::vector<Course>& sorted = courses.sorted();
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        uint64_t key = packCourseNumber(sorted[i].courseNumber);
+        if (keys.empty() || keys.back().first != key) {
+            keys.emplace_back(key, (uint32_t)i);
+        }
+    }
+
+    for (seed = 0x9e3779b97f4a7c15ULL; !place(keys); seed = mixBits(seed)) {
+    }
+}
+
+// try to place every key with the current seed
+bool CourseHashIndex::place(const std::vector<std::pair<uint64_t, uint32_t>>& keys) {
+    size_t n = keys.size();
+    pilots.assign(std::max<size_t>(1, (n + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET), 0);
+    slots.assign(n, Slot{0, 0});
+    if (n == 0) {
+        return true;
+    }
+
+    // group the keys (as indexes into keys, with their hashes) by bucket, largest buckets first
+    std::vector<std::vector<std::pair<uint64_t, uint32_t>>> buckets(pilots.size());
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t hash = mixBits(keys[i].first ^ seed);
+        buckets[bucketOf(hash)].emplace_back(hash, (uint32_t)i);
+    }
+    std::vector<uint32_t> order(buckets.size());
+    for (size_t b = 0; b < order.size(); ++b) {
+        order[b] = (uint32_t)b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<bool> taken(n, false);
+    std::vector<size_t> positions;
+    for (uint32_t b : order) {
+        const std::vector<std::pair<uint64_t, uint32_t>>& bucket = buckets[b];
+        if (bucket.empty()) {
+            break; // the rest are empty too
+        }
+        uint32_t pilot = 0;
+        for (;; ++pilot) {
+            if (pilot == MAX_PILOT) {
+                return false;
+            }
+            // every key of the bucket needs a free slot no other key of the bucket wants
+            positions.clear();
+            bool fits = true;
+            for (const std::pair<uint64_t, uint32_t>& entry : bucket) {
+                size_t position = slotOf(entry.first, pilot);
+                if (taken[position] || std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                    fits = false;
+                    break;
+                }
+                positions.push_back(position);
+            }
+            if (fits) {
+                break;
+            }
+        }
+        pilots[b] = pilot;
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            taken[positions[i]] = true;
+            slots[positions[i]] = Slot{keys[bucket[i].second].first, keys[bucket[i].second].second};
+        }
+    }
+    return true;
+}
+
+const Course* CourseHashIndex::find(const std::string& courseNumber) const {
+    if (slots.empty()) {
+        return nullptr;
+    }
+    uint64_t key = packCourseNumber(courseNumber);
+    uint64_t hash = mixBits(key ^ seed);
+    const Slot& slot = slots[slotOf(hash, pilots[bucketOf(hash)])];
+    if (slot.key != key) {
+        return nullptr; // the one key that hashes here is a different one
+    }
+    if (packedExactly(key)) {
+        return &catalog->sorted()[slot.course];
+    }
+    return catalog->matchUnpacked(slot.course, key, courseNumber);
+}
+
+// Prerequisite DAG compiled from a catalog
+// courses get dense ids in sorted order and edges become adjacency arrays; the transitive
+// closure is kept as one bitset row per strongly connected component (courses on one cycle
+// share it), computed the first time it is asked for and memoized, so a repeated query is a
+// row scan (n/64 words) and a single "is A required before B" test is one bit
+class PrerequisiteGraph {
+public:
+    // compile a sealed catalog, recording dangling references and cycles
+    void build(const FlatCatalog& catalog);
+
+    // every course that must be taken before courseNumber, directly or not, in course order
+    std::vector<std::string> requiredBefore(const std::string& courseNumber) const {
+        return closure(courseNumber, prerequisites, ancestorRows);
+    }
+
+    // every course that needs courseNumber, directly or not, in course order
+    std::vector<std::string> unlocks(const std::string& courseNumber) const {
+        return closure(courseNumber, dependents, descendantRows);
+    }
+
+    // true if before must be taken, directly or not, before course
+    bool isRequiredBefore(const std::string& before, const std::string& course) const;
+
+    // "CSCI300 -> MATH999" for every prerequisite that is not a course in the catalog
+    const std::vector<std::string>& danglingReferences() const { return dangling; }
+
+    // one course path per cycle, ending where it started
+    const std::vector<std::vector<std::string>>& cycles() const { return cyclePaths; }
+
+    // order the courses into semesters of at most cap courses (0 for no cap), each after all of
+    // its prerequisites; courses on or behind a cycle cannot be placed and go to unplanned
+    std::vector<std::vector<std::string>> planSemesters(size_t cap, std::vector<std::string>& unplanned) const;
+
+private:
+    std::vector<std::string> names;                    // id -> course number, sorted
+    std::unordered_map<std::string, int> ids;          // course number -> id
+    std::vector<std::vector<int>> prerequisites;       // id -> direct prerequisite ids
+    std::vector<std::vector<int>> dependents;          // id -> ids listing it as a prerequisite
+    std::vector<int> component;                        // id -> strongly connected component
+    std::vector<std::vector<int>> members;             // component -> ids
+    std::vector<bool> cyclic;                          // component lies on a cycle
+    size_t words = 0;                                  // 64-bit words per bitset row
+    std::vector<std::string> dangling;
+    std::vector<std::vector<std::string>> cyclePaths;
+
+    // memoized closure rows per component; only the thread reading the catalog fills them
+    mutable std::vector<std::vector<uint64_t>> ancestorRows;
+    mutable std::vector<std::vector<uint64_t>> descendantRows;
+
+    // levels at least this wide have their edges released by several threads
+    static const size_t PARALLEL_LEVEL = 4096;
+
+    void findComponents();
+    std::vector<int> levelize(const std::vector<std::vector<int>>& waitsOn,
+        const std::vector<std::vector<int>>& releases) const;
+    const std::vector<uint64_t>& row(int start, const std::vector<std::vector<int>>& edges,
+        std::vector<std::vector<uint64_t>>& rows) const;
+    std::vector<std::string> closure(const std::string& courseNumber,
+        const std::vector<std::vector<int>>& edges, std::vector<std::vector<uint64_t>>& rows) const;
+};
+
+void PrerequisiteGraph::build(const FlatCatalog& catalog) {
+    // ids are handed out in course order, so bit order is course order
+    std::vector<const Course*> courses;
+    for (const Course& course : catalog.sorted()) {
+        std::string key = normalizeCourseNumber(course.courseNumber);
+        if (ids.emplace(key, (int)names.size()).second) { // a repeated course number keeps its first entry
+            names.push_back(key);
+            courses.push_back(&course);
+        }
+    }
+
+    size_t n = names.size();
+    words = (n + 63) / 64;
+    prerequisites.assign(n, std::vector<int>());
+    dependents.assign(n, std::vector<int>());
+    for (size_t id = 0; id < n; ++id) {
+        for (const std::string& listed : courses[id]->prerequisites) {
+            std::string key = normalizeCourseNumber(listed);
+            if (key.empty()) {
+                continue;
+            }
+            auto found = ids.find(key);
+            if (found == ids.end()) {
+                dangling.push_back(names[id] + " -> " + key);
+                continue;
+            }
+            prerequisites[id].push_back(found->second);
+            dependents[found->second].push_back((int)id);
+        }
+    }
+
+    findComponents();
+    ancestorRows.assign(members.size(), std::vector<uint64_t>());
+    descendantRows.assign(members.size(), std::vector<uint64_t>());
+}
+
+// Tarjan's algorithm without recursion, so a long prerequisite chain cannot overflow the stack
+void PrerequisiteGraph::findComponents() {
+    size_t n = names.size();
+    std::vector<int> index(n, -1), low(n, 0);
+    std::vector<bool> onStack(n, false);
+    std::vector<int> stack;
+    std::vector<std::pair<int, size_t>> calls; // (course, next prerequisite to visit)
+    int counter = 0;
+    component.assign(n, -1);
+
+    for (size_t start = 0; start < n; ++start) {
+        if (index[start] >= 0) {
+            continue;
+        }
+        calls.push_back({ (int)start, 0 });
+        while (!calls.empty()) {
+            int node = calls.back().first;
+            size_t next = calls.back().second;
+            if (next == 0 && index[node] < 0) {
+                index[node] = low[node] = counter++;
+                stack.push_back(node);
+                onStack[node] = true;
+            }
+            if (next < prerequisites[node].size()) {
+                calls.back().second++;
+                int child = prerequisites[node][next];
+                if (index[child] < 0) {
+                    calls.push_back({ child, 0 });
+                }
+                else if (onStack[child]) {
+                    low[node] = std::min(low[node], index[child]);
+                }
+                continue;
+            }
+
+            // every prerequisite explored: close a component if node is its root
+            if (low[node] == index[node]) {
+                std::vector<int> group;
+                int member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    component[member] = (int)members.size();
+                    group.push_back(member);
+                } while (member != node);
+                members.push_back(group);
+            }
+            calls.pop_back();
+            if (!calls.empty()) {
+                int parent = calls.back().first;
+                low[parent] = std::min(low[parent], low[node]);
+            }
+        }
+    }
+
+    // a component is a cycle if it has several courses or a course listing itself
+    cyclic.assign(members.size(), false);
+    for (size_t c = 0; c < members.size(); ++c) {
+        int first = members[c][0];
+        bool selfLoop = std::find(prerequisites[first].begin(), prerequisites[first].end(), first)
+            != prerequisites[first].end();
+        if (members[c].size() < 2 && !selfLoop) {
+            continue;
+        }
+        cyclic[c] = true;
+
+        // walk prerequisites inside the component until a course repeats; that loop is a cycle
+        std::vector<int> path;
+        std::unordered_map<int, size_t> seenAt; // course -> position in path
+        int node = first;
+        while (seenAt.count(node) == 0) {
+            seenAt[node] = path.size();
+            path.push_back(node);
+            for (int child : prerequisites[node]) {
+                if (component[child] == (int)c) {
+                    node = child;
+                    break;
+                }
+            }
+        }
+        std::vector<std::string> cycle;
+        for (size_t i = seenAt[node]; i < path.size(); ++i) {
+            cycle.push_back(names[path[i]]);
+        }
+        cycle.push_back(names[node]);
+        cyclePaths.push_back(cycle);
+    }
+}
+
+// closure row of a component: every course reachable from its courses along edges
+// one breadth-first pass, O(n + m), the first time a component is asked for; only rows that were
+// asked for are kept, so memory grows with the queries made rather than with n * n
+const std::vector<uint64_t>& PrerequisiteGraph::row(int start, const std::vector<std::vector<int>>& edges,
+    std::vector<std::vector<uint64_t>>& rows) const {
+    if (!rows[start].empty()) {
+        return rows[start];
+    }
+    std::vector<uint64_t> bits(words, 0);
+    std::vector<int> frontier = members[start];
+    while (!frontier.empty()) {
+        int node = frontier.back();
+        frontier.pop_back();
+        for (int child : edges[node]) {
+            uint64_t mask = uint64_t(1) << (child % 64);
+            if ((bits[child / 64] & mask) == 0) {
+                bits[child / 64] |= mask;
+                frontier.push_back(child);
+            }
+        }
+    }
+    rows[start] = bits;
+    return rows[start];
+}
+
+std::vector<std::string> PrerequisiteGraph::closure(const std::string& courseNumber,
+    const std::vector<std::vector<int>>& edges, std::vector<std::vector<uint64_t>>& rows) const {
+    std::vector<std::string> out;
+    auto found = ids.find(normalizeCourseNumber(courseNumber));
+    if (found == ids.end()) {
+        return out;
+    }
+    const std::vector<uint64_t>& bits = row(component[found->second], edges, rows);
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            int id = (int)(w * 64 + lowestBit(word));
+            if (id != found->second) { // a course on a cycle reaches itself; that is reported separately
+                out.push_back(names[id]);
+            }
+        }
     }
-    return root;
+    return out;
 }
 
-//  load data from file into binary search tree
-TreeNode* loadDataStructure(const std::string& filePath) {
+// Kahn's algorithm one level at a time: a course's level is the length of the longest chain of
+// waitsOn edges below it, or -1 when it is on or behind a cycle and never becomes free
+// every course of a level is released before the next level starts, so a wide level can be split
+// across threads that count down the shared in-degrees atomically
+std::vector<int> PrerequisiteGraph::levelize(const std::vector<std::vector<int>>& waitsOn,
+    const std::vector<std::vector<int>>& releases) const {
+    size_t n = names.size();
+    std::vector<int> level(n, -1);
+    std::unique_ptr<std::atomic<int>[]> remaining(new std::atomic<int>[n]);
+    std::vector<int> frontier;
+    for (size_t c = 0; c < n; ++c) {
+        remaining[c] = (int)waitsOn[c].size();
+        if (waitsOn[c].empty()) {
+            frontier.push_back((int)c);
+        }
+    }
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int depth = 0; !frontier.empty(); ++depth) {
+        for (int c : frontier) {
+            level[c] = depth;
+        }
+
+        // release every edge out of this level; the last edge into a course frees it
+        size_t slices = frontier.size() >= PARALLEL_LEVEL ? threads : 1;
+        std::vector<std::vector<int>> freed(slices);
+        auto release = [&](size_t slice) {
+            size_t begin = frontier.size() * slice / slices;
+            size_t end = frontier.size() * (slice + 1) / slices;
+            for (size_t i = begin; i < end; ++i) {
+                for (int next : releases[frontier[i]]) {
+                    if (remaining[next].fetch_sub(1, std::memory_order_relaxed) == 1) {
+                        freed[slice].push_back(next);
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t slice = 1; slice < slices; ++slice) {
+            workers.emplace_back(release, slice);
+        }
+        release(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+        frontier.clear();
+        for (const std::vector<int>& part : freed) {
+            frontier.insert(frontier.end(), part.begin(), part.end());
+        }
+        std::sort(frontier.begin(), frontier.end()); // the same plan whatever the thread timing
+    }
+    return level;
+}
+
+std::vector<std::vector<std::string>> PrerequisiteGraph::planSemesters(size_t cap,
+    std::vector<std::string>& unplanned) const {
+    size_t n = names.size();
+    std::vector<std::vector<std::string>> semesters;
+    std::vector<int> depth = levelize(prerequisites, dependents); // earliest possible semester
+    for (size_t c = 0; c < n; ++c) {
+        if (depth[c] < 0) {
+            unplanned.push_back(names[c]);
+        }
+    }
+
+    // no cap: every course goes in its earliest semester
+    if (cap == 0) {
+        for (size_t c = 0; c < n; ++c) {
+            if (depth[c] >= 0) {
+                if ((size_t)depth[c] >= semesters.size()) {
+                    semesters.resize(depth[c] + 1);
+                }
+                semesters[depth[c]].push_back(names[c]);
+            }
+        }
+        return semesters;
+    }
+
+    // with a cap, fill each semester from the courses already free, longest chain still to come
+    // first (height), so the courses that hold up the most semesters are never left waiting
+    std::vector<int> height = levelize(dependents, prerequisites);
+    auto later = [&height](int a, int b) {
+        return height[a] != height[b] ? height[a] < height[b] : a > b;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(later)> ready(later);
+    std::vector<int> remaining(n);
+    for (size_t c = 0; c < n; ++c) {
+        remaining[c] = (int)prerequisites[c].size();
+        if (remaining[c] == 0) {
+            ready.push((int)c);
+        }
+    }
+    while (!ready.empty()) {
+        std::vector<int> term;
+        while (term.size() < cap && !ready.empty()) {
+            term.push_back(ready.top());
+            ready.pop();
+        }
+        // courses this term frees can only be taken from next term on
+        for (int c : term) {
+            for (int next : dependents[c]) {
+                if (--remaining[next] == 0) {
+                    ready.push(next);
+                }
+            }
+        }
+        std::sort(term.begin(), term.end());
+        semesters.push_back(std::vector<std::string>());
+        for (int c : term) {
+            semesters.back().push_back(names[c]);
+        }
+    }
+    return semesters;
+}
+
+bool PrerequisiteGraph::isRequiredBefore(const std::string& before, const std::string& course) const {
+    auto from = ids.find(normalizeCourseNumber(course));
+    auto to = ids.find(normalizeCourseNumber(before));
+    if (from == ids.end() || to == ids.end()) {
+        return false;
+    }
+    const std::vector<uint64_t>& bits = row(component[from->second], prerequisites, ancestorRows);
+    return (bits[to->second / 64] >> (to->second % 64)) & 1;
+}
+
+// one loaded course file: the sorted courses, their hash index, the type-ahead trie and the
+// prerequisite graph built from it
+// a catalog is never changed once published; loading a file builds a new one
+struct Catalog {
+    FlatCatalog courses;
+    CourseHashIndex courseIndex;
+    PrefixTrie courseTrie;
+    PrerequisiteGraph prerequisites;
+
+    Catalog() = default;
+
+    Catalog(const Catalog&) = delete;
+    Catalog& operator=(const Catalog&) = delete;
+};
+
+// Holds the published catalog version
+// readers pin() a version and keep a consistent view of it for as long as they hold it,
+// publish() swaps a new one in atomically, and the old one is freed when its last reader lets go
+class CatalogStore {
+public:
+    CatalogStore() : current(std::make_shared<const Catalog>()) {}
+
+    std::shared_ptr<const Catalog> pin() const {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return current.load();
+#else
+        return std::atomic_load(&current);
+#endif
+    }
+
+    void publish(Catalog* next) {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        current.store(std::shared_ptr<const Catalog>(next));
+#else
+        std::atomic_store(&current, std::shared_ptr<const Catalog>(next));
+#endif
+    }
+
+private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const Catalog>> current;
+#else
+    std::shared_ptr<const Catalog> current; // only touched through atomic_load/atomic_store
+#endif
+};
+
+// counters a load updates as it reads, safe to read from the menu thread while it runs
+struct LoadProgress {
+    std::atomic<size_t> bytesRead{0};
+    std::atomic<size_t> bytesTotal{0};
+    std::atomic<size_t> rows{0};
+    std::atomic<bool> cancelled{false}; // set to stop the load at the next line
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    double elapsed = 0.0; // seconds the whole load took, set when it completes
+    // what the load reports, printed by the menu thread once the load is collected
+    std::ostringstream output;
+    std::ostringstream errors;
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+};
+
+//  load data from file into a new catalog: a sorted course array, and course numbers in the type-ahead trie
+//  returns nullptr if the file cannot be opened or the load is cancelled through progress
+//  messages go to progress when there is one, so a background load never writes to the console
+Catalog* loadDataStructure(const std::string& filePath, LoadProgress* progress = nullptr) {
+    std::ostream& out = progress != nullptr ? progress->output : std::cout;
+    std::ostream& err = progress != nullptr ? progress->errors : std::cerr;
     std::ifstream file(filePath); // Open the file
     if (!file.is_open()) {
-        std::cerr << "Error: File not found." << std::endl;
+        err << "Error: File not found." << std::endl;
         return nullptr;
     }
+    if (progress != nullptr) { // size the progress bar, then rewind
+        file.seekg(0, std::ios::end);
+        progress->bytesTotal = (size_t)file.tellg();
+        file.seekg(0, std::ios::beg);
+    }
 
-    TreeNode* root = nullptr; // Initialize tree root
+    Catalog* catalog = new Catalog(); // built off to the side while readers use the old one
     std::string line;
 
-    std::cout << "Loading data from file..." << std::endl;
-
     while (std::getline(file, line)) { // Read file line by line
+        if (progress != nullptr) {
+            if (progress->cancelled) {
+                delete catalog;
+                return nullptr;
+            }
+            progress->bytesRead += line.size() + 1;
+            progress->rows++;
+        }
         std::istringstream iss(line);
         std::string component;
         std::vector<std::string> components;
@@ -77,7 +945,7 @@ TreeNode* loadDataStructure(const std::string& filePath) {
         }
 
         if (components.size() < 2) { // Validate line
-            std::cerr << "Error: Invalid line." << std::endl;
+            err << "Error: Invalid line." << std::endl;
             continue;
         }
 
@@ -95,114 +963,258 @@ TreeNode* loadDataStructure(const std::string& filePath) {
             course.prerequisites.clear(); // Clear prerequisites vector
         }
 
-        root = insertIntoBinarySearchTree(root, course); // Insert course into tree
+        catalog->courseTrie.insert(normalizeCourseNumber(course.courseNumber),
+            course.courseNumber + ", " + course.courseTitle); // index for type-ahead
+        catalog->courses.add(std::move(course)); // sorted once the whole file is in
     }
 
     file.close(); // Close the file
-    std::cout << "Data loaded successfully!" << std::endl;
-    return root;
-}
+    catalog->courses.seal();
+    catalog->courseIndex.build(catalog->courses); // one probe per course lookup from here on
 
+    // compile the prerequisite graph, reporting references it cannot resolve
+    catalog->prerequisites.build(catalog->courses);
+    for (const std::string& reference : catalog->prerequisites.danglingReferences()) {
+        err << "Warning: prerequisite not in catalog: " << reference << std::endl;
+    }
+    for (const std::vector<std::string>& cycle : catalog->prerequisites.cycles()) {
+        err << "Warning: prerequisite cycle: ";
+        for (size_t i = 0; i < cycle.size(); ++i) {
+            err << (i > 0 ? " -> " : "") << cycle[i];
+        }
+        err << std::endl;
+    }
 
-// Function to print course details
-void printCourseDetails(TreeNode* root, const std::string& courseNumber) {
-    if (root == nullptr) {
-        std::cout << "Error: Course not found." << std::endl;
-        return;
+    if (progress != nullptr) {
+        progress->elapsed = progress->seconds();
     }
+    out << "Data loaded successfully!" << std::endl;
+    return catalog;
+}
 
-    if (courseNumber == root->course.courseNumber) {
-        std::cout << "Course Number: " << root->course.courseNumber << std::endl;
-        std::cout << "Course Title: " << root->course.courseTitle << std::endl;
 
-        // Check if prerequisites vector is empty
-        if (root->course.prerequisites.empty()) {
-            std::cout << "Prerequisites: None" << std::endl;
-        }
-        else {
-            std::cout << "Prerequisites: ";
-            for (size_t i = 0; i < root->course.prerequisites.size(); ++i) {
-                std::cout << root->course.prerequisites[i];
-                if (i < root->course.prerequisites.size() - 1) {
-                    std::cout << ", ";
-                }
+// Append a course's details to a buffer, in the layout both print functions use
+void appendCourseDetails(std::string& out, const Course& course) {
+    out += "Course Number: ";
+    out += course.courseNumber;
+    out += "\nCourse Title: ";
+    out += course.courseTitle;
+
+    // Check if prerequisites vector is empty
+    if (course.prerequisites.empty()) {
+        out += "\nPrerequisites: None";
+    }
+    else {
+        out += "\nPrerequisites: ";
+        for (size_t i = 0; i < course.prerequisites.size(); ++i) {
+            out += course.prerequisites[i];
+            if (i < course.prerequisites.size() - 1) {
+                out += ", ";
             }
-            std::cout << std::endl;
         }
-        std::cout << std::endl; // Newline after all course details**
     }
-    else if (courseNumber < root->course.courseNumber) {
-        printCourseDetails(root->leftChild, courseNumber);
-    }
-    else {
-        printCourseDetails(root->rightChild, courseNumber);
+    out += "\n\n"; // Newline after all course details**
+}
+
+// Function to print course details
+void printCourseDetails(const CourseHashIndex& courses, const std::string& courseNumber) {
+    const Course* course = courses.find(courseNumber);
+    if (course == nullptr) {
+        std::cout << "Error: Course not found." << std::endl;
+        return;
     }
+    std::string details;
+    appendCourseDetails(details, *course);
+    std::cout << details << std::flush;
 }
 
 
 // Function to print all courses in sorted order
-void printSortedCourses(TreeNode* root) {
-    if (root != nullptr) {
-        printSortedCourses(root->leftChild);
-        std::cout << "Course Number: " << root->course.courseNumber << std::endl;
-        std::cout << "Course Title: " << root->course.courseTitle << std::endl;
-
-        // Check if prerequisites vector is empty
-        if (root->course.prerequisites.empty()) {
-            std::cout << "Prerequisites: None" << std::endl;
-        }
-        else {
-            std::cout << "Prerequisites: ";
-            for (size_t i = 0; i < root->course.prerequisites.size(); ++i) {
-                std::cout << root->course.prerequisites[i];
-                if (i < root->course.prerequisites.size() - 1) {
-                    std::cout << ", ";
-                }
-            }
-            std::cout << std::endl;
-        }
-        std::cout << std::endl; // Newline after all course details**
-        printSortedCourses(root->rightChild);
+// the courses are already sorted, so this is one scan into a buffer, then a single write and flush
+void printSortedCourses(const FlatCatalog& courses) {
+    std::string list;
+    for (const Course& course : courses.sorted()) {
+        appendCourseDetails(list, course);
     }
+    std::cout.write(list.data(), (std::streamsize)list.size());
+    std::cout.flush();
 }
 
 
 
 // Menu implementation
-void menu(TreeNode*& root) {
+void menu() {
+    CatalogStore catalogs;
+    std::future<Catalog*> pending; // a load running in the background, if any
+    std::unique_ptr<LoadProgress> progress;
     int choice;
     do {
         std::cout << "ABCU Computer Science Department" << std::endl;
         std::cout << "Menu:" << std::endl;
-        std::cout << "1. Load Course File" << std::endl;
+        std::cout << "1. Load Course File";
+        if (pending.valid() && progress->bytesTotal > 0) {
+            std::cout << " (" << progress->bytesRead * 100 / progress->bytesTotal << "% loaded)";
+        }
+        std::cout << std::endl;
         std::cout << "2. Print Course List" << std::endl;
         std::cout << "3. Print Selected Course and its Prerequisites" << std::endl;
+        std::cout << "4. Find Courses Starting With" << std::endl;
+        std::cout << "5. Print All Courses Required Before a Course" << std::endl;
+        std::cout << "6. Print All Courses a Course Unlocks" << std::endl;
+        std::cout << "7. Plan Semesters" << std::endl;
+        std::cout << "8. Check If a Course Is Required Before Another" << std::endl;
         std::cout << "9. Exit" << std::endl;
 
         std::cin >> choice;  // read user input
 
+        // publish a background load that has finished; a failed or cancelled one keeps the current catalog
+        if (pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            Catalog* loaded = pending.get();
+            std::cerr << progress->errors.str();
+            std::cout << progress->output.str();
+            if (loaded != nullptr) {
+                catalogs.publish(loaded);
+                std::cout << progress->rows << " lines loaded in " << progress->elapsed << " seconds" << std::endl;
+            }
+            else if (progress->cancelled) {
+                std::cout << "Load cancelled." << std::endl;
+            }
+        }
+        std::shared_ptr<const Catalog> catalog = catalogs.pin(); // one consistent version per command
+
         switch (choice) {
         case 1: {
+            if (pending.valid()) { // one load at a time: report it and offer to cancel
+                double seconds = progress->seconds();
+                std::cout << "Loaded " << progress->rows << " lines (" << progress->bytesRead << " of "
+                    << progress->bytesTotal << " bytes) in " << seconds << " seconds, "
+                    << (seconds > 0 ? progress->rows / seconds : 0) << " lines/s" << std::endl;
+                std::cout << "Cancel the load? (y/n) ";
+                std::string answer;
+                std::cin >> answer;
+                if (answer == "y" || answer == "Y") {
+                    progress->cancelled = true;
+                }
+                break;
+            }
             std::string filePath;
             std::cout << "Enter file path: (default path is Course.CSV)";
             std::cin >> filePath;
-            root = loadDataStructure(filePath);
+            // parse on a worker thread; the menu keeps answering from the catalog already published
+            progress.reset(new LoadProgress());
+            pending = std::async(std::launch::async, loadDataStructure, filePath, progress.get());
+            std::cout << "Loading data from file..." << std::endl;
             break;
         }
         case 2:
             std::cout << "Course Information:" << std::endl;
-            printSortedCourses(root);
+            printSortedCourses(catalog->courses);
             break;
         case 3: {
             std::string courseNumber;
             std::cout << "Enter Course Number: ";
             std::cin >> courseNumber;
-// Convert input to uppercase
-            courseNumber = toUpperCase(courseNumber);
-            printCourseDetails(root, courseNumber);
+            // the index folds case as it packs the number, so the input goes in as typed
+            printCourseDetails(catalog->courseIndex, courseNumber);
+            break;
+        }
+        case 4: {
+            std::string prefix;
+            std::cout << "Enter start of Course Number: ";
+            std::cin >> prefix;
+            // show the first ten matches in course order
+            std::vector<std::string> matches = catalog->courseTrie.complete(normalizeCourseNumber(prefix), 10);
+            if (matches.empty()) {
+                std::cout << "No courses found." << std::endl;
+            }
+            for (const std::string& match : matches) {
+                std::cout << match << std::endl;
+            }
+            std::cout << std::endl;
+            break;
+        }
+        case 5:
+        case 6: {
+            std::string courseNumber;
+            std::cout << "Enter Course Number: ";
+            std::cin >> courseNumber;
+            const Course* course = catalog->courseIndex.find(courseNumber);
+            if (course == nullptr) {
+                std::cout << "Error: Course not found." << std::endl;
+                break;
+            }
+            // transitive closure over the prerequisite graph, in course order
+            std::vector<std::string> courses = choice == 5
+                ? catalog->prerequisites.requiredBefore(courseNumber)
+                : catalog->prerequisites.unlocks(courseNumber);
+            std::cout << (choice == 5 ? "Required before " : "Unlocked by ") << course->courseNumber << ": ";
+            if (courses.empty()) {
+                std::cout << "None";
+            }
+            for (size_t i = 0; i < courses.size(); ++i) {
+                std::cout << (i > 0 ? ", " : "") << courses[i];
+            }
+            std::cout << std::endl << std::endl;
+            break;
+        }
+        case 7: {
+            size_t cap;
+            std::cout << "Enter most courses per semester (0 for no limit): ";
+            if (!(std::cin >> cap)) {
+                std::cin.clear();
+                std::cin.ignore(1000, '\n');
+                std::cout << "Invalid number." << std::endl;
+                break;
+            }
+            auto started = std::chrono::steady_clock::now();
+            std::vector<std::string> unplanned;
+            std::vector<std::vector<std::string>> semesters = catalog->prerequisites.planSemesters(cap, unplanned);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+            // format the whole plan, then write it at once
+            std::string plan;
+            for (size_t i = 0; i < semesters.size(); ++i) {
+                plan += "Semester " + std::to_string(i + 1) + ": ";
+                for (size_t j = 0; j < semesters[i].size(); ++j) {
+                    plan += (j > 0 ? ", " : "") + semesters[i][j];
+                }
+                plan += "\n";
+            }
+            if (!unplanned.empty()) {
+                plan += "Cannot be planned (prerequisite cycle): ";
+                for (size_t j = 0; j < unplanned.size(); ++j) {
+                    plan += (j > 0 ? ", " : "") + unplanned[j];
+                }
+                plan += "\n";
+            }
+            std::cout << plan << semesters.size() << " semesters planned in " << milliseconds << " ms"
+                << std::endl << std::endl;
+            break;
+        }
+        case 8: {
+            std::string before;
+            std::string courseNumber;
+            std::cout << "Enter Course Number: ";
+            std::cin >> courseNumber;
+            std::cout << "Enter possible prerequisite: ";
+            std::cin >> before;
+            const Course* course = catalog->courseIndex.find(courseNumber);
+            const Course* prerequisite = catalog->courseIndex.find(before);
+            if (course == nullptr || prerequisite == nullptr) {
+                std::cout << "Error: Course not found." << std::endl;
+                break;
+            }
+            // one bit of the course's closure row
+            bool required = catalog->prerequisites.isRequiredBefore(before, courseNumber);
+            std::cout << prerequisite->courseNumber << (required ? " is" : " is not") << " required before "
+                << course->courseNumber << std::endl << std::endl;
             break;
         }
         case 9:
+            if (pending.valid()) { // stop a load still running and drop what it built
+                progress->cancelled = true;
+                delete pending.get();
+            }
             std::cout << "Program Ended. Goodbye!" << std::endl;
             return;
         default:
@@ -213,8 +1225,75 @@ void menu(TreeNode*& root) {
 }
 
 // Main function
-int main() {
-    TreeNode* root = nullptr;
-    menu(root);
+// Time lookups of every course number in a file, plus as many misses, through the hash index,
+// the Eytzinger search and a pointer tree (std::map) keyed by normalized number, and check that
+// all three agree
+int benchmarkLookups(const std::string& filePath, size_t lookups) {
+    std::unique_ptr<Catalog> catalog(loadDataStructure(filePath));
+    if (catalog == nullptr) {
+        return 1;
+    }
+    const std::vector<Course>& courses = catalog->courses.sorted();
+    if (courses.empty()) {
+        std::cerr << "Error: no courses to look up." << std::endl;
+        return 1;
+    }
+    std::map<std::string, const Course*> tree;
+    for (const Course& course : courses) {
+        tree.emplace(normalizeCourseNumber(course.courseNumber), &course); // first of a repeated number
+    }
+
+    // the same shuffled queries for every method, half of them hits typed in lower case
+    std::mt19937 generator(42);
+    std::vector<std::string> queries(lookups);
+    for (std::string& query : queries) {
+        query = courses[generator() % courses.size()].courseNumber;
+        if (generator() % 2 == 0) {
+            query += "X"; // names no course
+        }
+        for (char& c : query) {
+            c = (char)std::tolower((unsigned char)c);
+        }
+    }
+
+    size_t mismatches = 0;
+    for (const std::string& query : queries) {
+        std::map<std::string, const Course*>::const_iterator node = tree.find(normalizeCourseNumber(query));
+        const Course* expected = node == tree.end() ? nullptr : node->second;
+        if (catalog->courseIndex.find(query) != expected || catalog->courses.find(query) != expected) {
+            ++mismatches;
+        }
+    }
+
+    std::cout << courses.size() << " courses, " << lookups << " lookups (half misses), "
+        << mismatches << " mismatches" << std::endl;
+    for (int method = 0; method < 3; ++method) {
+        size_t found = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (const std::string& query : queries) {
+            if (method == 0) {
+                found += catalog->courseIndex.find(query) != nullptr;
+            }
+            else if (method == 1) {
+                found += catalog->courses.find(query) != nullptr;
+            }
+            else {
+                found += tree.find(normalizeCourseNumber(query)) != tree.end();
+            }
+        }
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started).count();
+        const char* names[] = { "hash index:   ", "eytzinger:    ", "pointer tree: " };
+        std::cout << names[method] << nanoseconds / lookups << " ns per lookup (" << found << " found)" << std::endl;
+    }
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    // non-interactive lookup benchmark: --benchmark <course file> [lookups]
+    if (argc >= 3 && std::string(argv[1]) == "--benchmark") {
+        size_t lookups = argc >= 4 ? (size_t)std::strtoull(argv[3], nullptr, 10) : 2000000;
+        return benchmarkLookups(argv[2], std::max<size_t>(lookups, 1));
+    }
+    menu();
     return 0;
 }